@@ -0,0 +1,44 @@
+/**
+ * @file:   font.h
+ * @brief:  5x7 font for graphic displays
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef FONT_H_
+#define FONT_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  FONT FONT
+ * @brief     5x7 font for graphic displays
+ */
+
+/**
+ * @addtogroup FONT
+ * @{
+ */
+
+#define FONT_WIDTH        5 ///< Width of a character in pixels
+#define FONT_HEIGHT       7 ///< Height of a character in pixels
+#define FONT_CELL_WIDTH   6 ///< Width of a character with spacing
+#define FONT_CELL_HEIGHT  8 ///< Height of a character with spacing
+
+const uint8_t* FONT_GetChar(uint8_t c);
+
+/**
+ * @}
+ */
+
+#endif /* FONT_H_ */
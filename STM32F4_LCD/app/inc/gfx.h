@@ -0,0 +1,53 @@
+/**
+ * @file:   gfx.h
+ * @brief:  Framebuffer graphics
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef GFX_H_
+#define GFX_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  GFX GFX
+ * @brief     Framebuffer graphics
+ */
+
+/**
+ * @addtogroup GFX
+ * @{
+ */
+
+void      GFX_Init        (uint16_t* buffer, uint16_t width, uint16_t height);
+uint16_t  GFX_GetWidth    (void);
+uint16_t  GFX_GetHeight   (void);
+uint8_t   GFX_IsBusy      (void);
+void      GFX_Wait        (void);
+void      GFX_FillRect    (uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+    uint16_t color);
+void      GFX_Blit        (uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+    const uint16_t* pixels);
+void      GFX_Blend       (uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+    const uint16_t* pixels, uint8_t alpha);
+void      GFX_DrawChar    (uint16_t x, uint16_t y, uint8_t c,
+    uint16_t fg, uint16_t bg);
+void      GFX_DrawString  (uint16_t x, uint16_t y, const char* s,
+    uint16_t fg, uint16_t bg);
+
+/**
+ * @}
+ */
+
+#endif /* GFX_H_ */
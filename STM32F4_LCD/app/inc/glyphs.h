@@ -0,0 +1,42 @@
+/**
+ * @file:   glyphs.h
+ * @brief:  Custom LCD characters manager
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef GLYPHS_H_
+#define GLYPHS_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  GLYPH GLYPH
+ * @brief     Custom LCD characters manager
+ */
+
+/**
+ * @addtogroup GLYPH
+ * @{
+ */
+
+void    GLYPH_Init  (void);
+int8_t  GLYPH_Add   (const uint8_t* bitmap);
+int8_t  GLYPH_Use   (uint8_t id);
+void    GLYPH_Putc  (uint8_t id);
+
+/**
+ * @}
+ */
+
+#endif /* GLYPHS_H_ */
@@ -1,33 +1,73 @@
-/**
- * @file: 	hd44780.h
- * @brief:  HD44780 LCD library
- * @date: 	9 kwi 2014
- * @author: Michal Ksiezopolski
- *
- *
- * @verbatim
- * Copyright (c) 2014 Michal Ksiezopolski.
- * All rights reserved. This program and the
- * accompanying materials are made available
- * under the terms of the GNU Public License
- * v3.0 which accompanies this distribution,
- * and is available at
- * http://www.gnu.org/licenses/gpl.html
- * @endverbatim
- */
-
-#ifndef HD44780_H_
-#define HD44780_H_
-
-#include <inttypes.h>
-
-void LCD_Init(void);
-void LCD_Update(void);
-void LCD_Home(void);
-void LCD_Position(uint8_t positionX, uint8_t positionY);
-void LCD_Clear(void);
-void LCD_Putc(uint8_t c);
-void LCD_Puts(char* s);
-void LCD_ShifDisplay(uint8_t shift, uint8_t dir);
-
-#endif
+/**
+ * @file: 	hd44780.h
+ * @brief:  HD44780 LCD library
+ * @date: 	9 kwi 2014
+ * @author: Michal Ksiezopolski
+ *
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef HD44780_H_
+#define HD44780_H_
+
+#include <inttypes.h>
+#include <hd44780_hal.h> // LCD_DISPLAYS
+
+/*
+ * Uncomment to make LCD_Init non-blocking. The power-on
+ * sequence is then run from LCD_Update and text written
+ * before it ends waits in the queue.
+ */
+//#define LCD_ASYNC_INIT
+
+/**
+ * @brief Display numbers.
+ */
+typedef enum {
+  LCD0, //!< LCD0
+  LCD1, //!< LCD1
+  LCD2, //!< LCD2
+  LCD3, //!< LCD3
+} LCD_Display_TypeDef;
+
+/**
+ * @brief Supported display geometries (columns x rows).
+ */
+typedef enum {
+  LCD_16x1, //!< LCD_16x1 16 characters in one line
+  LCD_16x2, //!< LCD_16x2
+  LCD_20x2, //!< LCD_20x2
+  LCD_20x4, //!< LCD_20x4 two 40 character lines split in halves internally
+  LCD_40x2, //!< LCD_40x2
+} LCD_Geometry_TypeDef;
+
+void LCD_Init(LCD_Geometry_TypeDef geometry);
+void LCD_Update(void);
+void LCD_Select(LCD_Display_TypeDef display);
+LCD_Display_TypeDef LCD_GetSelected(void);
+uint8_t LCD_GetColumns(void);
+uint8_t LCD_GetRows(void);
+void LCD_Home(void);
+void LCD_Position(uint8_t positionX, uint8_t positionY);
+void LCD_Clear(void);
+void LCD_Putc(uint8_t c);
+void LCD_Puts(char* s);
+void LCD_ShifDisplay(uint8_t shift, uint8_t dir);
+void LCD_DefineChar(uint8_t code, const uint8_t* bitmap);
+void LCD_Write(uint8_t positionX, uint8_t positionY, const char* s, uint8_t len);
+int  LCD_Printf(uint8_t positionX, uint8_t positionY, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+void LCD_PutInt(uint8_t positionX, uint8_t positionY, uint8_t width, int32_t value);
+void LCD_PutFixed(uint8_t positionX, uint8_t positionY, uint8_t width,
+    int32_t value, uint8_t decimals);
+
+#endif
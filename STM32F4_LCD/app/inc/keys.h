@@ -20,6 +20,18 @@
 
 #include <inttypes.h>
 
+/*
+ * Keypad models - they differ in layout and in which lines
+ * of the keypad are connected to the column outputs.
+ */
+#define KEYS_KEYPAD_4X4         0 ///< 4x4 membrane, keypad rows on row inputs
+#define KEYS_KEYPAD_4X4_TACTILE 1 ///< 4x4 tactile, keypad rows on column outputs
+#define KEYS_KEYPAD_3X4         2 ///< 3x4 membrane, keypad rows on row inputs
+
+#ifndef KEYS_KEYPAD
+  #define KEYS_KEYPAD KEYS_KEYPAD_4X4 ///< Keypad in use
+#endif
+
 typedef enum {
   KEY0,
   KEY1,
@@ -33,10 +45,54 @@ typedef enum {
   KEY9,
   KEY_HASH,
   KEY_ASTERISK,
+  KEY_A,
+  KEY_B,
+  KEY_C,
+  KEY_D,
+  KEY_NAV_UP,
+  KEY_NAV_DOWN,
+  KEY_NAV_LEFT,
+  KEY_NAV_RIGHT,
+  KEY_ENTER,
+  KEY_BACK,
   KEY_NONE = 0xff
 } KEY_Id_Typedef;
 
+/**
+ * @brief Keymap layers.
+ */
+typedef enum {
+  KEY_LAYER_DIGITS,     //!< KEY_LAYER_DIGITS Keys as printed (digit and text entry)
+  KEY_LAYER_NAVIGATION, //!< KEY_LAYER_NAVIGATION 2/8/4/6 arrows, 5 and # enter, * back
+  KEY_LAYERS            //!< KEY_LAYERS Number of layers
+} KEY_Layer_Typedef;
+
+/**
+ * @brief Key event types.
+ */
+typedef enum {
+  KEY_DOWN,   //!< KEY_DOWN Key pressed
+  KEY_UP,     //!< KEY_UP Key released
+  KEY_LONG,   //!< KEY_LONG Key held for KEYS_LONG_TIME (once per press)
+  KEY_REPEAT, //!< KEY_REPEAT Key still held (auto-repeat)
+} KEY_EventType_Typedef;
+
+/**
+ * @brief Key event.
+ */
+typedef struct {
+  uint8_t type;   ///< Event type (KEY_EventType_Typedef)
+  uint8_t key;    ///< Key (KEY_Id_Typedef) in the layer active when it was pressed
+  uint8_t code;   ///< Key position (column << 4 | row)
+  uint32_t time;  ///< System time of the event (ms)
+} KEY_Event_Typedef;
+
 void KEYS_Init(void);
 uint8_t KEYS_Update(void);
+uint16_t KEYS_GetState(void);
+uint8_t KEYS_GetEvent(KEY_Event_Typedef* event);
+void KEYS_SetLayer(KEY_Layer_Typedef layer);
+KEY_Layer_Typedef KEYS_GetLayer(void);
+const char* KEYS_GetChars(uint8_t key);
 
 #endif /* KEYS_H_ */
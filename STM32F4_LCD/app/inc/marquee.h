@@ -0,0 +1,43 @@
+/**
+ * @file:   marquee.h
+ * @brief:  Scrolling text on the LCD
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef MARQUEE_H_
+#define MARQUEE_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  MARQUEE MARQUEE
+ * @brief     Scrolling text on the LCD
+ */
+
+/**
+ * @addtogroup MARQUEE
+ * @{
+ */
+
+void    MARQUEE_Init    (void);
+int8_t  MARQUEE_Add     (uint8_t positionX, uint8_t positionY, uint8_t width,
+    const char* text, uint16_t stepTime);
+void    MARQUEE_SetText (uint8_t id, const char* text);
+void    MARQUEE_Remove  (uint8_t id);
+
+/**
+ * @}
+ */
+
+#endif /* MARQUEE_H_ */
@@ -0,0 +1,72 @@
+/**
+ * @file:   menu.h
+ * @brief:  Hierarchical LCD menu
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef MENU_H_
+#define MENU_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  MENU MENU
+ * @brief     Hierarchical LCD menu
+ */
+
+/**
+ * @addtogroup MENU
+ * @{
+ */
+
+/**
+ * @brief Navigation keys.
+ */
+typedef enum {
+  MENU_UP,    //!< MENU_UP Previous item
+  MENU_DOWN,  //!< MENU_DOWN Next item
+  MENU_ENTER, //!< MENU_ENTER Enter submenu or run action
+  MENU_BACK,  //!< MENU_BACK Return to parent menu
+} MENU_Key_TypeDef;
+
+struct MENU_Menu;
+
+/**
+ * @brief Menu item.
+ */
+typedef struct {
+  const char* label;              ///< Text of the item
+  const struct MENU_Menu* submenu;///< Menu entered with MENU_ENTER (or NULL)
+  void (*action)(void);           ///< Called with MENU_ENTER if there is no submenu (or NULL)
+} MENU_Item_TypeDef;
+
+/**
+ * @brief Menu - define as const, so it stays in flash.
+ */
+typedef struct MENU_Menu {
+  const char* title;              ///< Shown in the first row (or NULL)
+  const MENU_Item_TypeDef* items; ///< Items
+  uint8_t count;                  ///< Number of items
+} MENU_TypeDef;
+
+void    MENU_Init     (const MENU_TypeDef* root);
+void    MENU_Key      (MENU_Key_TypeDef key);
+void    MENU_Redraw   (void);
+uint8_t MENU_GetItem  (void);
+
+/**
+ * @}
+ */
+
+#endif /* MENU_H_ */
@@ -0,0 +1,86 @@
+/**
+ * @file:   tft.h
+ * @brief:  SPI TFT display driver (ILI9341, ST7735)
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef TFT_H_
+#define TFT_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  TFT TFT
+ * @brief     SPI TFT display driver
+ */
+
+/**
+ * @addtogroup TFT
+ * @{
+ */
+
+/**
+ * @brief Supported controllers (portrait orientation).
+ */
+typedef enum {
+  TFT_ILI9341,  //!< TFT_ILI9341 240x320
+  TFT_ST7735,   //!< TFT_ST7735 128x160
+} TFT_Controller_TypeDef;
+
+/**
+ * @brief RGB565 color from 8-bit components.
+ */
+#define TFT_RGB(r, g, b) ((uint16_t)((((r) & 0xf8) << 8) | (((g) & 0xfc) << 3) | ((b) >> 3)))
+
+#define TFT_BLACK   TFT_RGB(0, 0, 0)        ///< Black
+#define TFT_WHITE   TFT_RGB(255, 255, 255)  ///< White
+#define TFT_RED     TFT_RGB(255, 0, 0)      ///< Red
+#define TFT_GREEN   TFT_RGB(0, 255, 0)      ///< Green
+#define TFT_BLUE    TFT_RGB(0, 0, 255)      ///< Blue
+#define TFT_YELLOW  TFT_RGB(255, 255, 0)    ///< Yellow
+
+void      TFT_Init        (TFT_Controller_TypeDef controller);
+uint8_t   TFT_IsBusy      (void);
+uint16_t  TFT_GetWidth    (void);
+uint16_t  TFT_GetHeight   (void);
+int8_t    TFT_FillRect    (uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+    uint16_t color);
+int8_t    TFT_DrawBitmap  (uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+    const uint16_t* pixels);
+void      TFT_SetColors   (uint16_t fg, uint16_t bg);
+
+/*
+ * Text API - same as of the HD44780 driver, positions are
+ * in character cells. When the job queue is full, TFT_Putc
+ * and TFT_Puts drop the text that doesn't fit (the cursor
+ * stays after the last character drawn), TFT_Write and
+ * TFT_Printf draw it with the next call.
+ */
+uint8_t   TFT_GetColumns  (void);
+uint8_t   TFT_GetRows     (void);
+void      TFT_Home        (void);
+void      TFT_Position    (uint8_t positionX, uint8_t positionY);
+void      TFT_Clear       (void);
+void      TFT_Putc        (uint8_t c);
+void      TFT_Puts        (char* s);
+void      TFT_Write       (uint8_t positionX, uint8_t positionY, const char* s,
+    uint8_t len);
+int       TFT_Printf      (uint8_t positionX, uint8_t positionY, const char* fmt, ...)
+    __attribute__((format(printf, 3, 4)));
+
+/**
+ * @}
+ */
+
+#endif /* TFT_H_ */
@@ -33,14 +33,31 @@
  * @{
  */
 
+/**
+ * @brief Soft timer modes.
+ */
+typedef enum {
+  TIMER_PERIODIC, //!< TIMER_PERIODIC Starts again after every overflow
+  TIMER_ONE_SHOT, //!< TIMER_ONE_SHOT Stops after the overflow
+} TIMER_Mode_TypeDef;
+
 void      TIMER_Init              (uint32_t freq);
 void      TIMER_DelayUS           (uint32_t us);
 void      TIMER_Delay             (uint32_t ms);
 uint8_t   TIMER_DelayTimer        (uint32_t ms, uint32_t startTime);
-int8_t    TIMER_AddSoftTimer      (uint32_t maxVal, void (*fun)(void));
-void      TIMER_StartSoftTimer    (uint8_t id);
+int16_t   TIMER_AddSoftTimer      (uint32_t maxVal, void (*fun)(void));
+int16_t   TIMER_CreateSoftTimer   (uint32_t maxVal, TIMER_Mode_TypeDef mode,
+    void (*fun)(void*), void* context);
+void      TIMER_DeleteSoftTimer   (uint16_t id);
+void      TIMER_StartSoftTimer    (uint16_t id);
+void      TIMER_RestartSoftTimer  (uint16_t id, uint32_t maxVal);
+void      TIMER_StopSoftTimer     (uint16_t id);
+void      TIMER_PauseSoftTimer    (uint16_t id);
+void      TIMER_ResumeSoftTimer   (uint16_t id);
+uint8_t   TIMER_IsSoftTimerRunning(uint16_t id);
 void      TIMER_SoftTimersUpdate  (void);
 uint32_t  TIMER_GetTime           (void);
+uint32_t  TIMER_GetTimeUS         (void);
 /**
  * @}
  */
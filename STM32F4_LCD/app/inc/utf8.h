@@ -0,0 +1,50 @@
+/**
+ * @file:   utf8.h
+ * @brief:  UTF-8 text on the LCD
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef UTF8_H_
+#define UTF8_H_
+
+#include <inttypes.h>
+
+/*
+ * Character ROM of the display: A00 (Japanese, default)
+ * or A02 (European). Uncomment for A02.
+ */
+//#define UTF8_ROM_A02
+
+/**
+ * @defgroup  UTF8 UTF8
+ * @brief     UTF-8 text on the LCD
+ */
+
+/**
+ * @addtogroup UTF8
+ * @{
+ */
+
+void      UTF8_Init   (void);
+uint32_t  UTF8_Decode (const char** s);
+uint8_t   UTF8_Map    (uint32_t codePoint);
+void      UTF8_Puts   (const char* s);
+void      UTF8_Write  (uint8_t positionX, uint8_t positionY, const char* s,
+    uint8_t width);
+
+/**
+ * @}
+ */
+
+#endif /* UTF8_H_ */
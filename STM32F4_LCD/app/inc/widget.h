@@ -0,0 +1,69 @@
+/**
+ * @file:   widget.h
+ * @brief:  LCD widgets redrawn only when changed
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef WIDGET_H_
+#define WIDGET_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  WIDGET WIDGET
+ * @brief     LCD widgets redrawn only when changed
+ */
+
+/**
+ * @addtogroup WIDGET
+ * @{
+ */
+
+/**
+ * @brief Kinds of rows formatted by WIDGET_FormatRow.
+ */
+typedef enum {
+  WIDGET_ROW_TEXT,      //!< WIDGET_ROW_TEXT Text only
+  WIDGET_ROW_ITEM,      //!< WIDGET_ROW_ITEM List item (space in the marker column)
+  WIDGET_ROW_SELECTED,  //!< WIDGET_ROW_SELECTED Selected list item (marked)
+} WIDGET_Row_TypeDef;
+
+void    WIDGET_Init       (void);
+int8_t  WIDGET_AddLabel   (uint8_t positionX, uint8_t positionY, uint8_t width,
+    const char* text);
+int8_t  WIDGET_AddNumber  (uint8_t positionX, uint8_t positionY, uint8_t width,
+    uint8_t decimals);
+int8_t  WIDGET_AddBar     (uint8_t positionX, uint8_t positionY, uint8_t width,
+    int32_t max);
+int8_t  WIDGET_AddList    (uint8_t positionX, uint8_t positionY, uint8_t width,
+    uint8_t rows, const char* const* items, uint8_t count);
+void    WIDGET_Remove     (uint8_t id);
+void    WIDGET_SetText    (uint8_t id, const char* text);
+void    WIDGET_SetValue   (uint8_t id, int32_t value);
+int32_t WIDGET_GetValue   (uint8_t id);
+void    WIDGET_Invalidate (uint8_t id);
+void    WIDGET_Render     (void);
+
+/*
+ * List helpers - also used by the menu.
+ */
+uint8_t WIDGET_ListTop    (uint8_t top, uint8_t selected, uint8_t rows);
+void    WIDGET_FormatRow  (char* buf, uint8_t width, WIDGET_Row_TypeDef kind,
+    const char* text);
+
+/**
+ * @}
+ */
+
+#endif /* WIDGET_H_ */
@@ -49,7 +49,7 @@ int main(void) {
 	TIMER_Init(SYSTICK_FREQ); // Initialize timer
 
 	// Add a soft timer with callback running every 1000ms
-	int8_t timerID = TIMER_AddSoftTimer(1000, softTimerCallback);
+	int16_t timerID = TIMER_AddSoftTimer(1000, softTimerCallback);
 	TIMER_StartSoftTimer(timerID); // start the timer
 
 	LED_Init(LED0); // Add an LED
@@ -61,7 +61,7 @@ int main(void) {
 
 	KEYS_Init(); // Initialize matrix keyboard
 
-  LCD_Init(); // Initialize the LCD
+  LCD_Init(LCD_16x2); // Initialize the LCD
 
   // Test the LCD
 
@@ -0,0 +1,307 @@
+/**
+ * @file:   gfx.c
+ * @brief:  Framebuffer graphics
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Draws into a RGB565 framebuffer in RAM. On parts with the
+ * DMA2D (see GFX_DMA2D in gfx_hal.h) fills, bitmaps and blends
+ * are done by DMA2D and the framebuffer is shown by LTDC.
+ * Otherwise everything is rendered by the CPU, which also
+ * builds on a PC (see sim/src/gfx_bench.c). Text is always
+ * rendered by the CPU, after DMA2D has finished.
+ *
+ * Drawing outside the framebuffer is rejected, as in tft.c.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <gfx.h>
+#include <gfx_hal.h>
+#include <font.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) printf("GFX--> "str"%s",##args,"\r")
+  #define println(str, args...) printf("GFX--> "str"%s",##args,"\r\n")
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+/**
+ * @addtogroup GFX
+ * @{
+ */
+
+#define GFX_RB_MASK 0x07e0f81f ///< RGB565 spread over 32 bits (G high, R and B low)
+
+/**
+ * @brief Two pixels stored at once (may alias the uint16_t framebuffer).
+ */
+typedef uint32_t __attribute__((may_alias)) GFX_Pair_TypeDef;
+
+static uint16_t* frame;       ///< Framebuffer
+static uint16_t frameWidth;   ///< Width in pixels
+static uint16_t frameHeight;  ///< Height in pixels
+
+static uint8_t GFX_Check(uint16_t x, uint16_t y, uint16_t w, uint16_t h);
+
+/**
+ * @brief Initialize the graphics.
+ * @param buffer Framebuffer (width*height pixels)
+ * @param width Width in pixels
+ * @param height Height in pixels
+ */
+void GFX_Init(uint16_t* buffer, uint16_t width, uint16_t height) {
+
+  frame = buffer;
+  frameWidth = width;
+  frameHeight = height;
+
+#ifdef GFX_DMA2D
+  GFX_HAL_Init(buffer, width, height);
+#endif
+}
+/**
+ * @brief Returns the width of the framebuffer.
+ * @return Width in pixels
+ */
+uint16_t GFX_GetWidth(void) {
+  return frameWidth;
+}
+/**
+ * @brief Returns the height of the framebuffer.
+ * @return Height in pixels
+ */
+uint16_t GFX_GetHeight(void) {
+  return frameHeight;
+}
+/**
+ * @brief Checks if drawing is still in progress.
+ * @retval 1 DMA2D is working
+ * @retval 0 Framebuffer is up to date
+ */
+uint8_t GFX_IsBusy(void) {
+#ifdef GFX_DMA2D
+  return GFX_HAL_IsBusy();
+#else
+  return 0;
+#endif
+}
+/**
+ * @brief Waits until drawing is done.
+ * @details Call before reading the framebuffer or reusing
+ * a bitmap passed to GFX_Blit or GFX_Blend.
+ */
+void GFX_Wait(void) {
+  while (GFX_IsBusy());
+}
+/**
+ * @brief Fills a rectangle with a color.
+ * @param x Left column
+ * @param y Top row
+ * @param w Width
+ * @param h Height
+ * @param color Color (RGB565)
+ */
+void GFX_FillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+    uint16_t color) {
+
+  if (GFX_Check(x, y, w, h)) {
+    return;
+  }
+
+  uint16_t* dst = frame + y * frameWidth + x;
+
+#ifdef GFX_DMA2D
+  GFX_HAL_Fill(dst, frameWidth - w, w, h, color);
+#else
+  uint32_t pair = color | ((uint32_t)color << 16);
+
+  while (h--) {
+    uint16_t* p = dst;
+    uint16_t n = w;
+
+    // two pixels per store from a word boundary
+    if (((uintptr_t)p & 2) && n) {
+      *p++ = color;
+      n--;
+    }
+    GFX_Pair_TypeDef* q = (GFX_Pair_TypeDef*)p;
+    while (n >= 2) {
+      *q++ = pair;
+      n -= 2;
+    }
+    p = (uint16_t*)q;
+    if (n) {
+      *p = color;
+    }
+    dst += frameWidth;
+  }
+#endif
+}
+/**
+ * @brief Copies a bitmap into the framebuffer.
+ * @param x Left column
+ * @param y Top row
+ * @param w Width
+ * @param h Height
+ * @param pixels w*h pixels (RGB565, row by row) - have to stay
+ * valid until drawn (see GFX_Wait)
+ */
+void GFX_Blit(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+    const uint16_t* pixels) {
+
+  if (GFX_Check(x, y, w, h)) {
+    return;
+  }
+
+  uint16_t* dst = frame + y * frameWidth + x;
+
+#ifdef GFX_DMA2D
+  GFX_HAL_Copy(dst, frameWidth - w, pixels, 0, w, h);
+#else
+  if (w == frameWidth) { // whole lines - one copy
+    memcpy(dst, pixels, (uint32_t)w * h * 2);
+    return;
+  }
+  while (h--) {
+    memcpy(dst, pixels, w * 2);
+    dst += frameWidth;
+    pixels += w;
+  }
+#endif
+}
+/**
+ * @brief Blends a bitmap with the framebuffer.
+ * @details Every pixel becomes pixel*alpha + old*(255-alpha).
+ * The software renderer uses 5-bit alpha.
+ * @param x Left column
+ * @param y Top row
+ * @param w Width
+ * @param h Height
+ * @param pixels w*h pixels (RGB565, row by row) - have to stay
+ * valid until drawn (see GFX_Wait)
+ * @param alpha Opacity of the bitmap (0..255)
+ */
+void GFX_Blend(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+    const uint16_t* pixels, uint8_t alpha) {
+
+  if (GFX_Check(x, y, w, h)) {
+    return;
+  }
+
+  uint16_t* dst = frame + y * frameWidth + x;
+
+#ifdef GFX_DMA2D
+  GFX_HAL_Blend(dst, frameWidth - w, pixels, 0, w, h, alpha);
+#else
+  uint32_t a = (alpha + 4) >> 3; // 0..32
+
+  if (a == 0) {
+    return;
+  }
+  if (a == 32) {
+    GFX_Blit(x, y, w, h, pixels);
+    return;
+  }
+
+  while (h--) {
+    uint16_t i;
+    for (i = 0; i < w; i++) {
+      // all three components mixed with one multiplication
+      uint32_t fg = pixels[i];
+      uint32_t bg = dst[i];
+      fg = (fg | (fg << 16)) & GFX_RB_MASK;
+      bg = (bg | (bg << 16)) & GFX_RB_MASK;
+      bg = ((((fg - bg) * a) >> 5) + bg) & GFX_RB_MASK;
+      dst[i] = (uint16_t)(bg | (bg >> 16));
+    }
+    dst += frameWidth;
+    pixels += w;
+  }
+#endif
+}
+/**
+ * @brief Draws a character.
+ * @details The whole cell (FONT_CELL_WIDTH x FONT_CELL_HEIGHT)
+ * is drawn, spacing in background color.
+ * @param x Left column
+ * @param y Top row
+ * @param c Character
+ * @param fg Text color
+ * @param bg Background color
+ */
+void GFX_DrawChar(uint16_t x, uint16_t y, uint8_t c,
+    uint16_t fg, uint16_t bg) {
+
+  if (GFX_Check(x, y, FONT_CELL_WIDTH, FONT_CELL_HEIGHT)) {
+    return;
+  }
+
+  GFX_Wait(); // DMA2D may be writing the same pixels
+
+  const uint8_t* glyph = FONT_GetChar(c);
+  uint16_t* dst = frame + y * frameWidth + x;
+
+  uint8_t i, j;
+  for (j = 0; j < FONT_CELL_HEIGHT; j++) {
+    for (i = 0; i < FONT_CELL_WIDTH; i++) {
+      uint8_t on = (i < FONT_WIDTH) && (glyph[i] & (1 << j));
+      dst[i] = on ? fg : bg;
+    }
+    dst += frameWidth;
+  }
+}
+/**
+ * @brief Draws a string in one line.
+ * @details Characters not fitting the framebuffer are skipped.
+ * @param x Left column
+ * @param y Top row
+ * @param s String
+ * @param fg Text color
+ * @param bg Background color
+ */
+void GFX_DrawString(uint16_t x, uint16_t y, const char* s,
+    uint16_t fg, uint16_t bg) {
+
+  while (*s && x + FONT_CELL_WIDTH <= frameWidth) {
+    GFX_DrawChar(x, y, *s++, fg, bg);
+    x += FONT_CELL_WIDTH;
+  }
+}
+/**
+ * @brief Checks if a rectangle lies inside the framebuffer.
+ * @param x Left column
+ * @param y Top row
+ * @param w Width
+ * @param h Height
+ * @retval 0 Rectangle OK
+ * @retval 1 Wrong rectangle
+ */
+static uint8_t GFX_Check(uint16_t x, uint16_t y, uint16_t w, uint16_t h) {
+
+  if (w == 0 || h == 0 || x + w > frameWidth || y + h > frameHeight) {
+    println("Wrong rectangle!");
+    return 1;
+  }
+  return 0;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,161 @@
+/**
+ * @file:   glyphs.c
+ * @brief:  Custom LCD characters manager
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * HD44780 has only 8 CGRAM slots for custom characters.
+ * Any number of glyphs (up to GLYPH_MAX) can be registered
+ * and the ones in use are mapped onto the slots. When all
+ * slots are taken the least recently used glyph is replaced,
+ * so CGRAM is reloaded only when the working set changes.
+ * Every display has its own CGRAM, so slots are managed
+ * for each display separately (the selected one is used).
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <glyphs.h>
+#include <hd44780.h>
+#include <stdio.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) printf("GLYPH--> "str"%s",##args,"\r")
+  #define println(str, args...) printf("GLYPH--> "str"%s",##args,"\r\n")
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+/**
+ * @addtogroup GLYPH
+ * @{
+ */
+
+#define GLYPH_MAX   32    ///< Maximum number of registered glyphs
+#define GLYPH_SLOTS 8     ///< Number of CGRAM slots
+#define GLYPH_NONE  0xff  ///< Empty slot or glyph not loaded
+
+static const uint8_t* glyphBitmap[GLYPH_MAX]; ///< Patterns of registered glyphs
+static uint8_t glyphCount;                    ///< Number of registered glyphs
+
+static uint8_t glyphSlot[LCD_DISPLAYS][GLYPH_MAX];      ///< CGRAM slot of each glyph
+static uint8_t slotGlyph[LCD_DISPLAYS][GLYPH_SLOTS];    ///< Glyph loaded in each slot
+static uint32_t slotLastUse[LCD_DISPLAYS][GLYPH_SLOTS]; ///< Time stamp of last use of each slot
+static uint32_t useCounter;                             ///< Time stamp counter
+
+/**
+ * @brief Initialize the glyph manager.
+ * @details Call after LCD_Init - all slots are considered empty.
+ */
+void GLYPH_Init(void) {
+
+  uint8_t i, d;
+
+  for (d = 0; d < LCD_DISPLAYS; d++) {
+    for (i = 0; i < GLYPH_MAX; i++) {
+      glyphSlot[d][i] = GLYPH_NONE;
+    }
+    for (i = 0; i < GLYPH_SLOTS; i++) {
+      slotGlyph[d][i] = GLYPH_NONE;
+      slotLastUse[d][i] = 0;
+    }
+  }
+  useCounter = 0;
+}
+/**
+ * @brief Registers a glyph.
+ * @param bitmap 8 rows of the 5x8 glyph (has to stay valid - keep it in flash)
+ * @return Glyph ID or error code (-1)
+ * @retval -1 Error: too many glyphs
+ */
+int8_t GLYPH_Add(const uint8_t* bitmap) {
+
+  if (glyphCount >= GLYPH_MAX) {
+    println("Reached maximum number of glyphs!");
+    return -1;
+  }
+
+  glyphBitmap[glyphCount] = bitmap;
+
+  uint8_t d;
+  for (d = 0; d < LCD_DISPLAYS; d++) {
+    glyphSlot[d][glyphCount] = GLYPH_NONE;
+  }
+
+  return glyphCount++;
+}
+/**
+ * @brief Makes a glyph available on the display.
+ * @details If the glyph isn't in CGRAM it replaces the least
+ * recently used one. Characters of the replaced glyph still
+ * visible on the display will change their look.
+ * @param id Glyph ID
+ * @return Character code to print (0 - 7) or error code (-1)
+ * @retval -1 Error: wrong glyph ID
+ */
+int8_t GLYPH_Use(uint8_t id) {
+
+  if (id >= glyphCount) {
+    println("Wrong glyph ID %d!", (int)id);
+    return -1;
+  }
+
+  uint8_t d = LCD_GetSelected();
+  uint8_t slot = glyphSlot[d][id];
+
+  if (slot == GLYPH_NONE) { // not loaded - find the LRU slot
+
+    uint8_t i;
+    slot = 0;
+    for (i = 0; i < GLYPH_SLOTS; i++) {
+      if (slotGlyph[d][i] == GLYPH_NONE) {
+        slot = i;
+        break;
+      }
+      if (slotLastUse[d][i] < slotLastUse[d][slot]) {
+        slot = i;
+      }
+    }
+
+    if (slotGlyph[d][slot] != GLYPH_NONE) {
+      glyphSlot[d][slotGlyph[d][slot]] = GLYPH_NONE; // evict old glyph
+    }
+
+    slotGlyph[d][slot] = id;
+    glyphSlot[d][id] = slot;
+    LCD_DefineChar(slot, glyphBitmap[id]);
+  }
+
+  slotLastUse[d][slot] = ++useCounter;
+
+  return slot;
+}
+/**
+ * @brief Prints a glyph at the current position.
+ * @param id Glyph ID
+ */
+void GLYPH_Putc(uint8_t id) {
+
+  int8_t code = GLYPH_Use(id);
+
+  if (code >= 0) {
+    LCD_Putc(code);
+  }
+}
+
+/**
+ * @}
+ */
@@ -1,359 +1,932 @@
-/**
- * @file: 	hd44780.c
- * @brief:
- * @date: 	9 kwi 2014
- * @author: Michal Ksiezopolski
- *
- *
- * @verbatim
- * Copyright (c) 2014 Michal Ksiezopolski.
- * All rights reserved. This program and the
- * accompanying materials are made available
- * under the terms of the GNU Public License
- * v3.0 which accompanies this distribution,
- * and is available at
- * http://www.gnu.org/licenses/gpl.html
- * @endverbatim
- */
-
-#include <hd44780.h>
-#include <timers.h>
-#include <fifo.h>
-#include <stdio.h>
-#include <hd44780_hal.h>
-
-#ifndef DEBUG
-  #define DEBUG
-#endif
-
-#ifdef DEBUG
-  #define print(str, args...) printf("LCD--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("LCD--> "str"%s",##args,"\r\n")
-#else
-  #define print(str, args...) (void)0
-  #define println(str, args...) (void)0
-#endif
-
-
-/*
- * LCD commands HD44780 (as per datasheet)
- */
-#define LCD_CLEAR_DISPLAY   0x01 ///< Clear the display and set DDRAM address to 0
-#define LCD_HOME            0x02 ///< Set DDRAM to 0, cancels any shifts
-#define LCD_ENTRY_MODE      0x04 ///< Sets cursor move direction and specifies display shift
-  #define LCD_INCREMENT     0x02 ///< Increments (1) or decrements (0) DDRAM address by 1 when data is written or read from DDRAM @see LCD_ENTRY_MODE
-  #define LCD_SHIFT_LEFT    0x01 ///< Shifts the entire display (1) in direction specified by ID bit when writing to DDRAM - display moves, not cursor. @see LCD_ENTRY_MODE
-#define LCD_DISPLAY_ON_OFF  0x08 ///< Sets display on/off, cursor on/off and blinking of cursor
-  #define LCD_DISPLAY_ON    0x04 ///< Display on/off bit @see LCD_DISPLAY_ON_OFF
-  #define LCD_CURSOR_ON     0x02 ///< Cursor on/off bit @see LCD_DISPLAY_ON_OFF
-  #define LCD_BLINK_ON      0x01 ///< Blink on/off bit @see LCD_DISPLAY_ON_OFF
-#define LCD_CURSOR_SHIFT    0x10 ///< Moves cursor and shift display without changing DDRAM contents
-  #define LCD_SHIFT_RIGHT   0x04 ///< Shift right bit (1), shift left (0) @see LCD_CURSOR_SHIFT
-  #define LCD_SHIFT_DISPLAY 0x08 ///< Display shift (1), cursor shift (0) @see LCD_CURSOR_SHIFT
-#define LCD_FUNCTION        0x20 ///< Sets interface data length, number of display lines and character font
-  #define LCD_2_ROWS        0x08 ///< Display 2 rows bit @see LCD_FUNCTION
-  #define LCD_FORMAT_5x10   0x04 ///< Format 5x10 pixels bit @see LCD_FUNCTION
-  #define LCD_8_BIT         0x10 ///< 8-bit interface bit @see LCD_FUNCTION
-#define LCD_SET_CGRAM       0x40 ///< Sets CGRAM address
-#define LCD_SET_DDRAM       0x80 ///< Sets DDRAM address
-
-#define LCD_ROW1 0x00     ///< First row address of the LCD
-#define LCD_ROW2 0x40     ///< Second row address of the LCD
-#define LCD_BUSY_FLAG (1<<7)  ///< Busy flag mask
-
-
-static void LCD_SendData(uint8_t data);
-static void LCD_SendCommand(uint8_t command);
-static uint8_t LCD_ReadFlag(void);
-
-#define LCD_BUF_LEN 256  	///< LCD buffer length
-#define LCD_DATA	  0x80	///< LCD data ID
-#define LCD_COMMAND	0x40	///< LCD command ID
-
-static uint8_t lcdBuffer[LCD_BUF_LEN]; 	///< Buffer for LCD commands and data
-static FIFO_TypeDef lcdFifo;			      ///< FIFO for LCD data
-
-/**
- * @brief Update the LCD.
- *
- * @details This function should be used in the main program loop
- * to send data and commands to the LCD. If the LCD is
- * busy the simply function returns and tries to send
- * the data later.
- */
-void LCD_Update(void) {
-
-	// If the LCD is still busy - do nothing in current run
-	if (LCD_ReadFlag()  & LCD_BUSY_FLAG)
-		return;
-
-	// If the LCD FIFO is empty
-	if (FIFO_IsEmpty(&lcdFifo))
-		return;
-
-	// First byte identifies whether we're dealing with data
-	// or a command
-	uint8_t dataOrCommand;
-	FIFO_Pop(&lcdFifo, &dataOrCommand);
-
-	// Second byte is the thing to be sent
-	uint8_t toSend;
-	FIFO_Pop(&lcdFifo, &toSend);
-
-	switch (dataOrCommand) {
-
-	// Send data
-	case LCD_DATA:
-		LCD_SendData(toSend);
-		break;
-
-	// Send a command
-	case LCD_COMMAND:
-		LCD_SendCommand(toSend);
-		break;
-
-	default:
-	  println("Neither data nor command!");
-	}
-}
-/**
- * @brief Initialize the display.
- * @warning This is a blocking function (can last about 60ms) - only called once though
- */
-void LCD_Init(void) {
-
-	// Wait 50 ms for voltage to settle.
-	TIMER_Delay(50);
-	// Initialize hardware
-	LCD_HAL_Init();
-
-	//initialization in 4-bit interface (as per datasheet)
-	LCD_HAL_Write(0b0011);
-	TIMER_Delay(5);
-
-	LCD_HAL_Write(0b0011);
-	TIMER_Delay(1);
-
-	LCD_HAL_Write(0b0011);
-	TIMER_Delay(1);
-
-	LCD_HAL_Write(0b0010);
-	TIMER_Delay(1);
-
-	// Initialize the LCD FIFO
-	lcdFifo.buf = lcdBuffer;
-	lcdFifo.len = LCD_BUF_LEN;
-
-	FIFO_Add(&lcdFifo);
-
-	// 2 row display
-	LCD_SendCommand(LCD_FUNCTION|LCD_2_ROWS);
-	// Wait until LCD is ready
-	while (LCD_ReadFlag()  & LCD_BUSY_FLAG);
-	// Turn on display, cursor and blinking
-	LCD_SendCommand(LCD_DISPLAY_ON_OFF|LCD_DISPLAY_ON|LCD_CURSOR_ON|LCD_BLINK_ON);
-	// Wait until LCD is ready
-	while (LCD_ReadFlag()  & LCD_BUSY_FLAG);
-	// Clear the display
-	LCD_SendCommand(LCD_CLEAR_DISPLAY);
-	// Wait until LCD is ready
-	while (LCD_ReadFlag()  & LCD_BUSY_FLAG);
-}
-/**
- * @brief Clear the display.
- * @details Write space code 20H to all DDRAM addresses.
- * Sets DDRAM address to 0. Removes all shifts.
- * Sets I/D to 1 (increment mode) in entry mode.
- */
-void LCD_Clear(void) {
-
-	FIFO_Push(&lcdFifo, LCD_COMMAND);
-	FIFO_Push(&lcdFifo, LCD_CLEAR_DISPLAY);
-}
-/**
- * @brief Go to the beginning of the display.
- * @details Sets DDRAM address to 0. Removes all shifts.
- */
-void LCD_Home(void) {
-
-	FIFO_Push(&lcdFifo, LCD_COMMAND);
-	FIFO_Push(&lcdFifo, LCD_HOME);
-}
-
-/**
- * @brief Position the LCD at a given memory location.
- * @param positionX Column of LCD
- * @param positionY Row of LCD - should be 0 (upper row) or 1 (lower row)
- */
-void LCD_Position(uint8_t positionX, uint8_t positionY) {
-
-	uint8_t new_pos;
-
-	switch (positionY) {
-
-	case 0:
-		new_pos = LCD_ROW1;
-		break;
-	case 1:
-		new_pos = LCD_ROW2;
-		break;
-	default:
-	  println("Wrong row!");
-		return;
-	}
-
-	new_pos += positionX;
-	FIFO_Push(&lcdFifo, LCD_COMMAND);
-	FIFO_Push(&lcdFifo, LCD_SET_DDRAM | (new_pos & 0x7f));
-}
-/**
- * @brief Shifts the display in the specified direction.
- * @param shift Amount of chars to shift by.
- * @param dir Direction of shift: 0 - left, 1 - right
- */
-void LCD_ShifDisplay(uint8_t shift, uint8_t dir) {
-
-	switch (dir) {
-
-	case 0:
-		break;
-
-	case 1:
-		dir = LCD_SHIFT_RIGHT;
-		break;
-
-	default:
-	  println("Wrong direction!");
-		return;
-	}
-
-	uint8_t i;
-	for (i = 0; i < shift; i++) {
-		FIFO_Push(&lcdFifo, LCD_COMMAND);
-		FIFO_Push(&lcdFifo, LCD_CURSOR_SHIFT | LCD_SHIFT_DISPLAY | dir);
-	}
-
-}
-/**
- * @brief Sets the cursor of the LCD
- * @param onOff Cursor on/off
- * @param blink Should cursor blink
- */
-void LCD_SetCursor(uint8_t onOff, uint8_t blink) {
-
-  // cursor on/off
-	switch (onOff) {
-
-	case 0:
-		break;
-
-	case 1:
-		onOff = LCD_CURSOR_ON;
-		break;
-
-	default:
-		println("Wrong parameter in LCD_SetCursor!");
-		return;
-	}
-
-	// cursor blink
-	switch (blink) {
-
-	case 0:
-		break;
-
-	case 1:
-		blink = LCD_BLINK_ON;
-		break;
-
-	default:
-	  println("Wrong parameter in LCD_SetCursor!");
-		return;
-	}
-
-	FIFO_Push(&lcdFifo, LCD_COMMAND);
-	FIFO_Push(&lcdFifo, LCD_DISPLAY_ON_OFF | LCD_DISPLAY_ON | blink | onOff);
-
-}
-/**
- * @brief Print a character.
- * @param c Character to print.
- */
-void LCD_Putc(uint8_t c) {
-
-	FIFO_Push(&lcdFifo, LCD_DATA);
-	FIFO_Push(&lcdFifo, c);
-}
-/**
- * @brief Print a string ended with '\0'.
- * @param s String
- */
-void LCD_Puts(char* s) {
-
-	uint8_t i=0;
-	while (s[i]!='\0') {
-		LCD_Putc((uint8_t)s[i++]);
-	}
-}
-/**
- * @brief Send data to LCD.
- * @param data Data to send.
- */
-static void LCD_SendData(uint8_t data) {
-
-	// rs high and rw low for writing data
-  LCD_HAL_HighRS();
-	LCD_HAL_LowRW();
-
-	LCD_HAL_DataOut(); // data as output
-
-	// write higher 4 bits first
-	LCD_HAL_HighE();
-	LCD_HAL_Write(data>>4);
-	LCD_HAL_LowE();
-
-	LCD_HAL_HighE();
-	LCD_HAL_Write(data);
-	LCD_HAL_LowE();
-
-}
-
-/**
- * @brief Send a command to the LCD.
- * @param command Command to send.
- */
-static void LCD_SendCommand(uint8_t command) {
-
-	// rs low and rw low for writing command
-  LCD_HAL_LowRW();
-  LCD_HAL_LowRS();
-
-	LCD_HAL_DataOut(); // data as output
-
-	// write higher 4 bits first
-	LCD_HAL_HighE();
-	LCD_HAL_Write(command>>4);
-	LCD_HAL_LowE();
-
-	LCD_HAL_HighE();
-	LCD_HAL_Write(command);
-	LCD_HAL_LowE();
-}
-
-/**
- * @brief Read busy flag.
- * @return Returns read byte.
- */
-static uint8_t LCD_ReadFlag(void) {
-
-	LCD_HAL_DataIn(); // lines as input
-	LCD_HAL_LowRS();
-	LCD_HAL_HighRW(); // read
-
-	uint8_t result = 0;
-	result = (LCD_HAL_Read() << 4);
-	result |= LCD_HAL_Read();
-	return result;
-
-}
-
+/**
+ * @file: 	hd44780.c
+ * @brief:
+ * @date: 	9 kwi 2014
+ * @author: Michal Ksiezopolski
+ *
+ *
+ * @verbatim
+ * Copyright (c) 2014 Michal Ksiezopolski.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <hd44780.h>
+#include <timers.h>
+#include <fifo.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <hd44780_hal.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) printf("LCD--> "str"%s",##args,"\r")
+  #define println(str, args...) printf("LCD--> "str"%s",##args,"\r\n")
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+
+/*
+ * LCD commands HD44780 (as per datasheet)
+ */
+#define LCD_CLEAR_DISPLAY   0x01 ///< Clear the display and set DDRAM address to 0
+#define LCD_HOME            0x02 ///< Set DDRAM to 0, cancels any shifts
+#define LCD_ENTRY_MODE      0x04 ///< Sets cursor move direction and specifies display shift
+  #define LCD_INCREMENT     0x02 ///< Increments (1) or decrements (0) DDRAM address by 1 when data is written or read from DDRAM @see LCD_ENTRY_MODE
+  #define LCD_SHIFT_LEFT    0x01 ///< Shifts the entire display (1) in direction specified by ID bit when writing to DDRAM - display moves, not cursor. @see LCD_ENTRY_MODE
+#define LCD_DISPLAY_ON_OFF  0x08 ///< Sets display on/off, cursor on/off and blinking of cursor
+  #define LCD_DISPLAY_ON    0x04 ///< Display on/off bit @see LCD_DISPLAY_ON_OFF
+  #define LCD_CURSOR_ON     0x02 ///< Cursor on/off bit @see LCD_DISPLAY_ON_OFF
+  #define LCD_BLINK_ON      0x01 ///< Blink on/off bit @see LCD_DISPLAY_ON_OFF
+#define LCD_CURSOR_SHIFT    0x10 ///< Moves cursor and shift display without changing DDRAM contents
+  #define LCD_SHIFT_RIGHT   0x04 ///< Shift right bit (1), shift left (0) @see LCD_CURSOR_SHIFT
+  #define LCD_SHIFT_DISPLAY 0x08 ///< Display shift (1), cursor shift (0) @see LCD_CURSOR_SHIFT
+#define LCD_FUNCTION        0x20 ///< Sets interface data length, number of display lines and character font
+  #define LCD_2_ROWS        0x08 ///< Display 2 rows bit @see LCD_FUNCTION
+  #define LCD_FORMAT_5x10   0x04 ///< Format 5x10 pixels bit @see LCD_FUNCTION
+  #define LCD_8_BIT         0x10 ///< 8-bit interface bit @see LCD_FUNCTION
+#define LCD_SET_CGRAM       0x40 ///< Sets CGRAM address
+#define LCD_SET_DDRAM       0x80 ///< Sets DDRAM address
+
+#ifdef LCD_8BIT
+  #define LCD_INTERFACE LCD_8_BIT ///< Data length bit of function set
+#else
+  #define LCD_INTERFACE 0         ///< Data length bit of function set
+#endif
+
+#define LCD_BUSY_FLAG (1<<7)  ///< Busy flag mask
+
+#define LCD_MAX_ROWS    4   ///< Maximum number of rows of supported displays
+#define LCD_MAX_COLUMNS 40  ///< Maximum number of columns of supported displays
+#define LCD_MAX_CHARS   80  ///< Size of DDRAM (maximum number of characters)
+
+/**
+ * @brief Display geometry descriptor.
+ */
+typedef struct {
+  uint8_t columns;                  ///< Number of columns
+  uint8_t rows;                     ///< Number of rows
+  uint8_t rowAddress[LCD_MAX_ROWS]; ///< DDRAM address of first character in each row
+} LCD_GeometryDesc_TypeDef;
+
+/**
+ * @brief Descriptors of supported geometries (indexed by LCD_Geometry_TypeDef).
+ */
+static const LCD_GeometryDesc_TypeDef lcdGeometries[] = {
+  [LCD_16x1] = {16, 1, {0x00}},
+  [LCD_16x2] = {16, 2, {0x00, 0x40}},
+  [LCD_20x2] = {20, 2, {0x00, 0x40}},
+  [LCD_20x4] = {20, 4, {0x00, 0x40, 0x14, 0x54}},
+  [LCD_40x2] = {40, 2, {0x00, 0x40}},
+};
+
+
+/*
+ * Worst case execution times of the instructions (datasheet values
+ * for fosc = 270kHz scaled to the minimum fosc of 190kHz).
+ * Used only when the busy flag can't be read (LCD_WRITE_ONLY).
+ */
+#ifndef LCD_EXEC_TIME_SHORT
+  #define LCD_EXEC_TIME_SHORT 53   ///< Execution time of most instructions in us
+#endif
+#ifndef LCD_EXEC_TIME_DATA
+  #define LCD_EXEC_TIME_DATA  59   ///< Execution time of a DDRAM/CGRAM write in us
+#endif
+#ifndef LCD_EXEC_TIME_LONG
+  #define LCD_EXEC_TIME_LONG  2160 ///< Execution time of clear and home in us
+#endif
+
+/*
+ * The FIFO holds runs of transfers of the same kind. Each run
+ * starts with a header - LCD_DATA or LCD_COMMAND ORed with the
+ * number of bytes that follow. While a run is still waiting in
+ * the FIFO, next bytes of the same kind are appended to it,
+ * so a string costs about one byte per character.
+ */
+#define LCD_BUF_LEN 256  	///< LCD buffer length
+#define LCD_DATA	  0x80	///< LCD data run header
+#define LCD_COMMAND	0x40	///< LCD command run header
+#define LCD_DATA_MAX    0x7f  ///< Maximum length of data run
+#define LCD_COMMAND_MAX 0x3f  ///< Maximum length of command run
+#define LCD_RUN_ROOM    2     ///< FIFO bytes a transfer takes at most (header of a new run and the byte)
+
+/**
+ * @brief Step of initialization by instruction.
+ */
+typedef struct {
+  uint8_t wait;   ///< Time to wait before the step in ms
+  uint8_t nibble; ///< Nibble to write (LCD_INIT_WAIT - only wait)
+} LCD_InitStep_TypeDef;
+
+#define LCD_INIT_WAIT 0xff ///< Step without a write
+
+/**
+ * @brief Initialization by instruction (as per datasheet).
+ */
+static const LCD_InitStep_TypeDef lcdInitSteps[] = {
+  {50, 0b0011},         // wait 50 ms for voltage to settle
+  { 5, 0b0011},
+  { 1, 0b0011},
+#ifndef LCD_8BIT
+  { 1, 0b0010},         // switch to 4-bit interface
+#endif
+  { 1, LCD_INIT_WAIT},  // after this the busy flag can be read
+};
+
+#define LCD_INIT_STEPS (sizeof(lcdInitSteps)/sizeof(lcdInitSteps[0])) ///< Number of init steps
+
+/**
+ * @brief State of one display.
+ */
+typedef struct {
+  const LCD_GeometryDesc_TypeDef* geometry; ///< Geometry of the display
+  uint8_t buffer[LCD_BUF_LEN];    ///< Buffer for LCD commands and data
+  FIFO_TypeDef fifo;              ///< FIFO for LCD data
+  uint8_t shadow[LCD_MAX_CHARS];  ///< Copy of characters on the display (row by row)
+  uint8_t cursorX;                ///< Current column (equal to number of columns if row is full)
+  uint8_t cursorY;                ///< Current row
+  uint16_t runHeader;             ///< FIFO index of header of the last run
+  uint8_t runOpen;                ///< Can bytes still be appended to the last run?
+  uint8_t pendingType;            ///< Kind of run being sent (LCD_DATA or LCD_COMMAND)
+  uint8_t pendingCount;           ///< Bytes left in run being sent
+  uint8_t initStep;               ///< Next step of initialization
+  uint32_t initTime;              ///< Time of the last init step in ms
+#ifdef LCD_WRITE_ONLY
+  uint32_t lastOpTime;            ///< Time of the last transfer in us
+  uint32_t execTime;              ///< Execution time of the last transfer in us
+#endif
+} LCD_TypeDef;
+
+static LCD_TypeDef lcds[LCD_DISPLAYS];  ///< All displays
+static LCD_TypeDef* lcd = &lcds[LCD0];  ///< Selected display
+
+static void LCD_SendData(LCD_Display_TypeDef display, uint8_t data);
+static void LCD_SendCommand(LCD_Display_TypeDef display, uint8_t command);
+static uint8_t LCD_IsBusy(LCD_Display_TypeDef display);
+static uint8_t LCD_InitStep(LCD_Display_TypeDef display);
+static uint8_t LCD_HasRoom(uint8_t transfers);
+static int8_t LCD_Queue(uint8_t type, uint8_t byte);
+static int8_t LCD_QueueData(uint8_t data);
+static int8_t LCD_QueueCommand(uint8_t command);
+static int8_t LCD_QueuePosition(uint8_t positionX, uint8_t positionY);
+
+/**
+ * @brief Update the LCD.
+ *
+ * @details This function should be used in the main program loop
+ * to send data and commands to the LCD. If the LCD is
+ * busy the simply function returns and tries to send
+ * the data later.
+ */
+void LCD_Update(void) {
+
+	static uint8_t next; // display served first in this run
+
+#ifdef LCD_I2C
+	LCD_HAL_Update(); // transport starts its next transaction
+#endif
+
+	// Displays share the bus - while one is busy, the others
+	// can be served. Each gets at most one transfer per run.
+	uint8_t i;
+	for (i = 0; i < LCD_DISPLAYS; i++) {
+
+	  uint8_t display = (next + i) % LCD_DISPLAYS;
+	  LCD_TypeDef* d = &lcds[display];
+
+	  // If the LCD FIFO is empty (or display not initialized)
+	  if (d->fifo.len == 0 || FIFO_IsEmpty(&d->fifo))
+	    continue;
+
+	  // Power-on sequence not finished yet - writes stay queued
+	  if (d->initStep < LCD_INIT_STEPS && !LCD_InitStep(display))
+	    continue;
+
+	  // If the LCD is still busy - do nothing in current run
+	  if (LCD_IsBusy(display))
+	    continue;
+
+	  // Start of a run - header identifies whether we're dealing
+	  // with data or commands and how many bytes follow
+	  if (d->pendingCount == 0) {
+
+	    // no more appending once the header is taken
+	    if (d->runOpen && d->runHeader == d->fifo.tail) {
+	      d->runOpen = 0;
+	    }
+
+	    uint8_t header;
+	    FIFO_Pop(&d->fifo, &header);
+
+	    if (header & LCD_DATA) {
+	      d->pendingType  = LCD_DATA;
+	      d->pendingCount = header & LCD_DATA_MAX;
+	    } else {
+	      d->pendingType  = LCD_COMMAND;
+	      d->pendingCount = header & LCD_COMMAND_MAX;
+	    }
+	  }
+
+	  // Next byte of the run is the thing to be sent
+	  uint8_t toSend;
+	  if (FIFO_Pop(&d->fifo, &toSend)) {
+	    d->pendingCount = 0;
+	    continue;
+	  }
+	  d->pendingCount--;
+
+	  switch (d->pendingType) {
+
+	  // Send data
+	  case LCD_DATA:
+	    LCD_SendData(display, toSend);
+	    break;
+
+	  // Send a command
+	  case LCD_COMMAND:
+	    LCD_SendCommand(display, toSend);
+	    break;
+
+	  default:
+	    println("Neither data nor command!");
+	  }
+	}
+
+	next = (next + 1) % LCD_DISPLAYS;
+}
+/**
+ * @brief Selects the display used by the other LCD functions.
+ * @param display Display number
+ */
+void LCD_Select(LCD_Display_TypeDef display) {
+
+	if (display >= LCD_DISPLAYS) {
+	  println("Wrong display %d!", (int)display);
+	  return;
+	}
+
+	lcd = &lcds[display];
+}
+/**
+ * @brief Returns the selected display.
+ * @return Display number
+ */
+LCD_Display_TypeDef LCD_GetSelected(void) {
+	return lcd - lcds;
+}
+/**
+ * @brief Initialize the selected display.
+ *
+ * @details The setup commands are queued in the FIFO and sent
+ * by LCD_Update once the power-on sequence is over. With
+ * LCD_ASYNC_INIT defined the function returns at once and the
+ * sequence is run from LCD_Update - text written in the meantime
+ * is queued.
+ *
+ * @param geometry Size of the display (16x2 is used if it is wrong)
+ * @warning Without LCD_ASYNC_INIT this is a blocking function (can last about 60ms)
+ */
+void LCD_Init(LCD_Geometry_TypeDef geometry) {
+
+	if (geometry >= sizeof(lcdGeometries)/sizeof(lcdGeometries[0])) {
+	  println("Wrong geometry, using 16x2!");
+	  geometry = LCD_16x2; // the driver needs a valid geometry
+	}
+	lcd->geometry = &lcdGeometries[geometry];
+
+	LCD_Display_TypeDef display = LCD_GetSelected();
+
+	// Initialize hardware
+	LCD_HAL_Init();
+
+	// Start of the power-on sequence
+	lcd->initStep = 0;
+	lcd->initTime = TIMER_GetTime();
+
+	// Initialize the LCD FIFO
+	lcd->fifo.buf = lcd->buffer;
+	lcd->fifo.len = LCD_BUF_LEN;
+
+	FIFO_Add(&lcd->fifo);
+	lcd->runOpen = 0;
+	lcd->pendingCount = 0;
+
+	// 1 or 2 line mode (4 row displays are 2 line internally)
+	if (lcd->geometry->rows > 1) {
+	  LCD_QueueCommand(LCD_FUNCTION|LCD_INTERFACE|LCD_2_ROWS);
+	} else {
+	  LCD_QueueCommand(LCD_FUNCTION|LCD_INTERFACE);
+	}
+	// Turn on display, cursor and blinking
+	LCD_QueueCommand(LCD_DISPLAY_ON_OFF|LCD_DISPLAY_ON|LCD_CURSOR_ON|LCD_BLINK_ON);
+	// Clear the display
+	LCD_QueueCommand(LCD_CLEAR_DISPLAY);
+
+	memset(lcd->shadow, ' ', sizeof(lcd->shadow));
+	lcd->cursorX = 0;
+	lcd->cursorY = 0;
+
+#ifndef LCD_ASYNC_INIT
+	// Wait until the setup commands are sent and executed
+	while (!FIFO_IsEmpty(&lcd->fifo) || LCD_IsBusy(display)) {
+	  LCD_Update();
+	}
+#else
+	(void)display;
+#endif
+}
+/**
+ * @brief Returns the number of columns of the display.
+ * @return Number of columns
+ */
+uint8_t LCD_GetColumns(void) {
+  return lcd->geometry->columns;
+}
+/**
+ * @brief Returns the number of rows of the display.
+ * @return Number of rows
+ */
+uint8_t LCD_GetRows(void) {
+  return lcd->geometry->rows;
+}
+/**
+ * @brief Clear the display.
+ * @details Write space code 20H to all DDRAM addresses.
+ * Sets DDRAM address to 0. Removes all shifts.
+ * Sets I/D to 1 (increment mode) in entry mode.
+ */
+void LCD_Clear(void) {
+
+	// shadow stays as it is, so LCD_Write still fixes the display
+	if (LCD_QueueCommand(LCD_CLEAR_DISPLAY)) {
+	  return;
+	}
+
+	memset(lcd->shadow, ' ', sizeof(lcd->shadow));
+	lcd->cursorX = 0;
+	lcd->cursorY = 0;
+}
+/**
+ * @brief Go to the beginning of the display.
+ * @details Sets DDRAM address to 0. Removes all shifts.
+ */
+void LCD_Home(void) {
+
+	if (LCD_QueueCommand(LCD_HOME)) {
+	  return;
+	}
+
+	lcd->cursorX = 0;
+	lcd->cursorY = 0;
+}
+
+/**
+ * @brief Position the LCD at a given memory location.
+ * @param positionX Column of LCD
+ * @param positionY Row of LCD (0 is the upper row)
+ */
+void LCD_Position(uint8_t positionX, uint8_t positionY) {
+
+	if (positionY >= lcd->geometry->rows) {
+	  println("Wrong row!");
+		return;
+	}
+	if (positionX >= lcd->geometry->columns) {
+	  println("Wrong column!");
+	  return;
+	}
+
+	LCD_QueuePosition(positionX, positionY);
+}
+/**
+ * @brief Shifts the display in the specified direction.
+ * @param shift Amount of chars to shift by.
+ * @param dir Direction of shift: 0 - left, 1 - right
+ */
+void LCD_ShifDisplay(uint8_t shift, uint8_t dir) {
+
+	switch (dir) {
+
+	case 0:
+		break;
+
+	case 1:
+		dir = LCD_SHIFT_RIGHT;
+		break;
+
+	default:
+	  println("Wrong direction!");
+		return;
+	}
+
+	// shifting by a whole DDRAM line gives the same picture
+	shift %= (lcd->geometry->rows > 1) ? LCD_MAX_CHARS/2 : LCD_MAX_CHARS;
+
+	uint8_t i;
+	for (i = 0; i < shift; i++) {
+		LCD_QueueCommand(LCD_CURSOR_SHIFT | LCD_SHIFT_DISPLAY | dir);
+	}
+
+}
+/**
+ * @brief Sets the cursor of the LCD
+ * @param onOff Cursor on/off
+ * @param blink Should cursor blink
+ */
+void LCD_SetCursor(uint8_t onOff, uint8_t blink) {
+
+  // cursor on/off
+	switch (onOff) {
+
+	case 0:
+		break;
+
+	case 1:
+		onOff = LCD_CURSOR_ON;
+		break;
+
+	default:
+		println("Wrong parameter in LCD_SetCursor!");
+		return;
+	}
+
+	// cursor blink
+	switch (blink) {
+
+	case 0:
+		break;
+
+	case 1:
+		blink = LCD_BLINK_ON;
+		break;
+
+	default:
+	  println("Wrong parameter in LCD_SetCursor!");
+		return;
+	}
+
+	LCD_QueueCommand(LCD_DISPLAY_ON_OFF | LCD_DISPLAY_ON | blink | onOff);
+
+}
+/**
+ * @brief Print a character.
+ * @details Text continues in the next row when the current
+ * one is full. Character '\n' moves to the beginning of
+ * the next row (use 0x02 for CGRAM character 2).
+ * @param c Character to print.
+ */
+void LCD_Putc(uint8_t c) {
+
+	if (c == '\n') {
+	  LCD_QueuePosition(0, (lcd->cursorY + 1) % lcd->geometry->rows);
+	  return;
+	}
+
+	// row full - wrap to the next one
+	if (lcd->cursorX == lcd->geometry->columns) {
+
+	  // address and character go together or not at all
+	  if (!LCD_HasRoom(2)) {
+	    println("Queue full!");
+	    return;
+	  }
+
+	  uint8_t nextAddress = lcd->geometry->rowAddress[lcd->cursorY] + lcd->cursorX;
+
+	  // in 2 line mode address counter jumps between the lines
+	  if (lcd->geometry->rows > 1) {
+	    if (nextAddress == 0x28) {
+	      nextAddress = 0x40;
+	    } else if (nextAddress == 0x68) {
+	      nextAddress = 0x00;
+	    }
+	  }
+
+	  uint8_t nextRow = (lcd->cursorY + 1) % lcd->geometry->rows;
+
+	  // address counter doesn't always continue in the next row
+	  if (nextAddress != lcd->geometry->rowAddress[nextRow]) {
+	    LCD_QueuePosition(0, nextRow); // fits - checked above
+	  } else {
+	    lcd->cursorX = 0;
+	    lcd->cursorY = nextRow;
+	  }
+	}
+
+	// dropped - shadow and cursor stay as they were
+	if (LCD_QueueData(c)) {
+	  return;
+	}
+
+	lcd->shadow[lcd->cursorY * lcd->geometry->columns + lcd->cursorX] = c;
+	lcd->cursorX++;
+}
+/**
+ * @brief Print a string ended with '\0'.
+ * @param s String
+ */
+void LCD_Puts(char* s) {
+
+	uint8_t i=0;
+	while (s[i]!='\0') {
+		LCD_Putc((uint8_t)s[i++]);
+	}
+}
+/**
+ * @brief Writes text to a region of the display.
+ * @details Only characters that differ from what is already
+ * displayed are sent, so refreshing a field with the same or
+ * slightly changed value costs (almost) no bus transfers.
+ * Text is clipped at the end of the row.
+ * @param positionX Column of the first character
+ * @param positionY Row
+ * @param s Text
+ * @param len Number of characters
+ */
+void LCD_Write(uint8_t positionX, uint8_t positionY, const char* s, uint8_t len) {
+
+	if (positionY >= lcd->geometry->rows || positionX >= lcd->geometry->columns) {
+	  println("Wrong position!");
+	  return;
+	}
+
+	if (len > lcd->geometry->columns - positionX) {
+	  len = lcd->geometry->columns - positionX;
+	}
+
+	uint8_t* shadow = &lcd->shadow[positionY * lcd->geometry->columns];
+
+	uint8_t i;
+	for (i = 0; i < len; i++) {
+
+	  uint8_t x = positionX + i;
+
+	  if (shadow[x] == (uint8_t)s[i]) {
+	    continue; // already on display
+	  }
+	  // set address only if cursor isn't already there
+	  if (lcd->cursorX != x || lcd->cursorY != positionY) {
+
+	    // address and character go together or not at all
+	    if (!LCD_HasRoom(2)) {
+	      println("Queue full!");
+	      return;
+	    }
+	    LCD_QueuePosition(x, positionY); // fits - checked above
+	  }
+
+	  // the rest of the shadow stays, next write sends it again
+	  if (LCD_QueueData(s[i])) {
+	    return;
+	  }
+	  shadow[x] = s[i];
+	  lcd->cursorX++;
+	}
+}
+/**
+ * @brief Formatted print to a given position.
+ * @details Works like printf, but the output goes through
+ * LCD_Write, so only changed characters are sent.
+ * @param positionX Column
+ * @param positionY Row
+ * @param fmt Format string
+ * @return Number of characters written (clipped to the row)
+ */
+int LCD_Printf(uint8_t positionX, uint8_t positionY, const char* fmt, ...) {
+
+	char buf[LCD_MAX_COLUMNS + 1];
+	va_list args;
+
+	va_start(args, fmt);
+	int len = vsnprintf(buf, sizeof(buf), fmt, args);
+	va_end(args);
+
+	if (len < 0) {
+	  return len;
+	}
+	if (len > LCD_MAX_COLUMNS) {
+	  len = LCD_MAX_COLUMNS;
+	}
+
+	LCD_Write(positionX, positionY, buf, len);
+
+	return len;
+}
+/**
+ * @brief Prints a fixed point number right aligned in a field.
+ * @details Doesn't use printf. If the number doesn't fit, the
+ * field is filled with '*'.
+ * @param positionX Column of the field
+ * @param positionY Row of the field
+ * @param width Field width
+ * @param value Value multiplied by 10^decimals (e.g. 1234 for 12.34)
+ * @param decimals Number of digits after the decimal point
+ */
+void LCD_PutFixed(uint8_t positionX, uint8_t positionY, uint8_t width,
+    int32_t value, uint8_t decimals) {
+
+	char buf[LCD_MAX_COLUMNS];
+	uint32_t absValue = (value < 0) ? -(uint32_t)value : (uint32_t)value;
+	uint8_t digits = 0;
+	uint8_t fits = 1;
+
+	if (width > LCD_MAX_COLUMNS) {
+	  width = LCD_MAX_COLUMNS;
+	}
+
+	uint8_t i = width; // buffer is filled from the right
+
+	// at least one digit before the decimal point
+	do {
+	  if (decimals && digits == decimals) {
+	    if (i == 0) {
+	      fits = 0;
+	      break;
+	    }
+	    buf[--i] = '.';
+	  }
+	  if (i == 0) {
+	    fits = 0;
+	    break;
+	  }
+	  buf[--i] = '0' + absValue % 10;
+	  absValue /= 10;
+	  digits++;
+	} while (absValue || digits <= decimals);
+
+	if (fits && value < 0) {
+	  if (i == 0) {
+	    fits = 0;
+	  } else {
+	    buf[--i] = '-';
+	  }
+	}
+
+	if (fits) {
+	  memset(buf, ' ', i);
+	} else {
+	  memset(buf, '*', width);
+	}
+
+	LCD_Write(positionX, positionY, buf, width);
+}
+/**
+ * @brief Prints an integer right aligned in a field.
+ * @param positionX Column of the field
+ * @param positionY Row of the field
+ * @param width Field width
+ * @param value Value to print
+ */
+void LCD_PutInt(uint8_t positionX, uint8_t positionY, uint8_t width, int32_t value) {
+
+	LCD_PutFixed(positionX, positionY, width, value, 0);
+}
+/**
+ * @brief Defines a custom character.
+ * @details The pattern is written to CGRAM and the DDRAM address
+ * is restored afterwards, so printing continues where it was.
+ * Characters already on the display using this code change too.
+ * @param code Character code (0 - 7)
+ * @param bitmap 8 rows of the character, 5 lower bits of each are used
+ */
+void LCD_DefineChar(uint8_t code, const uint8_t* bitmap) {
+
+	if (code > 7) {
+	  println("Wrong CGRAM character!");
+	  return;
+	}
+
+	// a partial definition would leave the address in CGRAM
+	if (!LCD_HasRoom(1 + 8 + 1)) {
+	  println("Queue full!");
+	  return;
+	}
+
+	LCD_QueueCommand(LCD_SET_CGRAM | (code << 3));
+
+	uint8_t i;
+	for (i = 0; i < 8; i++) {
+	  LCD_QueueData(bitmap[i] & 0x1f);
+	}
+
+	LCD_QueuePosition(lcd->cursorX, lcd->cursorY); // back to DDRAM
+}
+/**
+ * @brief Checks whether transfers surely fit in the FIFO of the selected LCD.
+ * @details Assumes each transfer starts a new run.
+ * @param transfers Number of transfers
+ * @retval 1 Transfers fit
+ * @retval 0 Some of them may be dropped
+ */
+static uint8_t LCD_HasRoom(uint8_t transfers) {
+
+	return lcd->fifo.len - lcd->fifo.count >= transfers * LCD_RUN_ROOM;
+}
+/**
+ * @brief Queues a byte for sending to the selected LCD.
+ * @details The byte is appended to the last run if it has
+ * the same kind and is still in the FIFO, otherwise a new
+ * run is started. Nothing is queued if it doesn't fit - the
+ * run is closed then, so a later byte isn't sent to the
+ * address following the earlier ones.
+ * @param type LCD_DATA or LCD_COMMAND
+ * @param byte Data or command
+ * @retval 0 Byte queued
+ * @retval -1 Queue full, byte dropped
+ */
+static int8_t LCD_Queue(uint8_t type, uint8_t byte) {
+
+	FIFO_TypeDef* fifo = &lcd->fifo;
+	uint16_t space = fifo->len - fifo->count;
+
+	if (lcd->runOpen) {
+
+	  uint8_t header = fifo->buf[lcd->runHeader];
+	  uint8_t runType = (header & LCD_DATA) ? LCD_DATA : LCD_COMMAND;
+	  uint8_t max = (type == LCD_DATA) ? LCD_DATA_MAX : LCD_COMMAND_MAX;
+
+	  // same kind and still room in the run
+	  if (runType == type && (header & max) < max) {
+
+	    if (space < 1) {
+	      println("Queue full!");
+	      lcd->runOpen = 0;
+	      return -1;
+	    }
+	    FIFO_Push(fifo, byte);
+	    fifo->buf[lcd->runHeader] = header + 1;
+	    return 0;
+	  }
+	}
+
+	// new run - header and byte
+	if (space < LCD_RUN_ROOM) {
+	  println("Queue full!");
+	  lcd->runOpen = 0;
+	  return -1;
+	}
+
+	lcd->runHeader = fifo->head;
+	lcd->runOpen = 1;
+	FIFO_Push(fifo, type | 1);
+	FIFO_Push(fifo, byte);
+
+	return 0;
+}
+/**
+ * @brief Queues data for sending to the LCD.
+ * @param data Data byte
+ * @retval 0 Data queued
+ * @retval -1 Queue full
+ */
+static int8_t LCD_QueueData(uint8_t data) {
+
+	return LCD_Queue(LCD_DATA, data);
+}
+/**
+ * @brief Queues a command for sending to the LCD.
+ * @param command Command byte
+ * @retval 0 Command queued
+ * @retval -1 Queue full
+ */
+static int8_t LCD_QueueCommand(uint8_t command) {
+
+	return LCD_Queue(LCD_COMMAND, command);
+}
+/**
+ * @brief Queues setting the DDRAM address and moves the cursor there.
+ * @details The cursor is moved only if the command was queued.
+ * @param positionX Column
+ * @param positionY Row
+ * @retval 0 Command queued
+ * @retval -1 Queue full
+ */
+static int8_t LCD_QueuePosition(uint8_t positionX, uint8_t positionY) {
+
+	// just after the end of a row - continue in the next one, like LCD_Putc
+	if (positionX >= lcd->geometry->columns) {
+	  positionX = 0;
+	  positionY = (positionY + 1) % lcd->geometry->rows;
+	}
+
+	uint8_t address = lcd->geometry->rowAddress[positionY] + positionX;
+	if (LCD_QueueCommand(LCD_SET_DDRAM | (address & 0x7f))) {
+	  return -1;
+	}
+
+	lcd->cursorX = positionX;
+	lcd->cursorY = positionY;
+	return 0;
+}
+/**
+ * @brief Send data to LCD.
+ * @param display Display number
+ * @param data Data to send.
+ */
+static void LCD_SendData(LCD_Display_TypeDef display, uint8_t data) {
+
+	LCD_HAL_Select(display);
+	LCD_HAL_Send(data, 1); // rs high for writing data
+
+#ifdef LCD_WRITE_ONLY
+	lcds[display].lastOpTime = TIMER_GetTimeUS();
+	lcds[display].execTime   = LCD_EXEC_TIME_DATA;
+#endif
+}
+
+/**
+ * @brief Send a command to the LCD.
+ * @param display Display number
+ * @param command Command to send.
+ */
+static void LCD_SendCommand(LCD_Display_TypeDef display, uint8_t command) {
+
+	LCD_HAL_Select(display);
+	LCD_HAL_Send(command, 0); // rs low for writing command
+
+#ifdef LCD_WRITE_ONLY
+	lcds[display].lastOpTime = TIMER_GetTimeUS();
+	// clear display and return home take much longer than the rest
+	if (command == LCD_CLEAR_DISPLAY || (command & ~0x01) == LCD_HOME) {
+	  lcds[display].execTime = LCD_EXEC_TIME_LONG;
+	} else {
+	  lcds[display].execTime = LCD_EXEC_TIME_SHORT;
+	}
+#endif
+}
+
+/**
+ * @brief Checks if the LCD is still executing the last instruction.
+ * @details Reads the busy flag or, if RW is tied to ground, compares
+ * the time since the last transfer with its execution time. Transfers
+ * buffered by the HAL are taken into account.
+ * @param display Display number
+ * @retval 1 LCD is busy
+ * @retval 0 LCD is ready for next transfer
+ */
+static uint8_t LCD_IsBusy(LCD_Display_TypeDef display) {
+
+#ifdef LCD_WRITE_ONLY
+  LCD_TypeDef* d = &lcds[display];
+
+  LCD_HAL_Select(display);
+  uint8_t queued = LCD_HAL_Queued();
+
+  // transport (I2C) can't take more now
+  if (queued >= LCD_HAL_QUEUE_LEN) {
+    return 1;
+  }
+  // clear and home are timed from when they leave the transport
+  if (queued && d->execTime == LCD_EXEC_TIME_LONG) {
+    d->lastOpTime = TIMER_GetTimeUS();
+    return 1;
+  }
+
+  return (TIMER_GetTimeUS() - d->lastOpTime) < d->execTime;
+#else
+  LCD_HAL_Select(display);
+  return (LCD_HAL_ReadStatus() & LCD_BUSY_FLAG) ? 1 : 0;
+#endif
+}
+/**
+ * @brief Runs the power-on sequence of a display.
+ * @details Performs the steps which are due and returns.
+ * @param display Display number
+ * @retval 1 Sequence finished
+ * @retval 0 Sequence still in progress
+ */
+static uint8_t LCD_InitStep(LCD_Display_TypeDef display) {
+
+  LCD_TypeDef* d = &lcds[display];
+
+  while (d->initStep < LCD_INIT_STEPS) {
+
+    const LCD_InitStep_TypeDef* step = &lcdInitSteps[d->initStep];
+
+    if (!TIMER_DelayTimer(step->wait, d->initTime)) {
+      return 0;
+    }
+
+    if (step->nibble != LCD_INIT_WAIT) {
+      LCD_HAL_Select(display);
+      LCD_HAL_WriteNibble(step->nibble, 0);
+    }
+
+    d->initTime = TIMER_GetTime();
+    d->initStep++;
+  }
+
+  return 1;
+}
+
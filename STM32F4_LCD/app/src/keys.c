@@ -32,77 +32,390 @@
   #define println(str, args...) (void)0
 #endif
 
-#define DEBOUNCE_TIME 200 ///< Key debounce time in ms
+/*
+ * Scanning: one column per timer tick, its rows are read one
+ * tick later (time for the lines to settle). A key has to be
+ * seen in KEYS_DEBOUNCE consecutive passes over all columns to
+ * be pressed and missed as many times to be released, so the
+ * latency is KEYS_DEBOUNCE * KEYS_COLUMNS * KEYS_SCAN_PERIOD.
+ */
+#ifndef KEYS_SCAN_PERIOD
+  #define KEYS_SCAN_PERIOD  1000  ///< Time between columns in us
+#endif
+#ifndef KEYS_DEBOUNCE
+  #define KEYS_DEBOUNCE     4     ///< Passes needed to change key state
+#endif
+
+/*
+ * Times of held key events in ms (0 - no such events)
+ */
+#ifndef KEYS_LONG_TIME
+  #define KEYS_LONG_TIME    1000  ///< Hold time of the long press event
+#endif
+#ifndef KEYS_REPEAT_DELAY
+  #define KEYS_REPEAT_DELAY 500   ///< Hold time of the first repeat event
+#endif
+#ifndef KEYS_REPEAT_RATE
+  #define KEYS_REPEAT_RATE  100   ///< Time between next repeat events
+#endif
+
+#define KEYS_QUEUE_LEN  16  ///< Length of event queue (power of 2)
+
+#define KEYS_COUNT (KEYS_ROWS * KEYS_COLUMNS) ///< Number of keys
+#define KEYS_PASS_TIME (KEYS_COLUMNS * KEYS_SCAN_PERIOD) ///< Time of one pass in us
+#define KEYS_PASSES(ms) (((ms) * 1000UL + KEYS_PASS_TIME - 1) / KEYS_PASS_TIME) ///< Passes in a time
+
+static uint8_t currentColumn;           ///< Selected keyboard column
+static uint16_t rawState;               ///< Keys seen in the current pass
+static uint8_t integrators[KEYS_COUNT]; ///< Debounce counters (0 - KEYS_DEBOUNCE)
+static uint16_t holdTime[KEYS_COUNT];   ///< Passes since the key was pressed
+static volatile uint16_t keysState;     ///< Debounced keys (bit per key)
+static uint8_t keysPressed[KEYS_COUNT]; ///< Key of each position at the time of press
+static volatile uint8_t keysLayer;      ///< Active layer
+
+/*
+ * Keymaps - layers of the keypad as it is seen from the front
+ * ([layer][keypad row][keypad column]). KEYS_MAP finds the key
+ * of a scan position, depending on how the keypad is wired.
+ */
+#if KEYS_KEYPAD == KEYS_KEYPAD_4X4 || KEYS_KEYPAD == KEYS_KEYPAD_4X4_TACTILE
+
+static const uint8_t keymap[KEY_LAYERS][4][4] = {
+  [KEY_LAYER_DIGITS] = {
+    {KEY1,          KEY2,         KEY3,           KEY_A},
+    {KEY4,          KEY5,         KEY6,           KEY_B},
+    {KEY7,          KEY8,         KEY9,           KEY_C},
+    {KEY_ASTERISK,  KEY0,         KEY_HASH,       KEY_D},
+  },
+  [KEY_LAYER_NAVIGATION] = {
+    {KEY1,          KEY_NAV_UP,   KEY3,           KEY_A},
+    {KEY_NAV_LEFT,  KEY_ENTER,    KEY_NAV_RIGHT,  KEY_B},
+    {KEY7,          KEY_NAV_DOWN, KEY9,           KEY_C},
+    {KEY_BACK,      KEY0,         KEY_ENTER,      KEY_D},
+  },
+};
+
+#if KEYS_KEYPAD == KEYS_KEYPAD_4X4
+  #define KEYS_MAP(layer, col, row) keymap[layer][row][col]
+#else
+  #define KEYS_MAP(layer, col, row) keymap[layer][col][row]
+#endif
+
+#elif KEYS_KEYPAD == KEYS_KEYPAD_3X4
+
+static const uint8_t keymap[KEY_LAYERS][4][3] = {
+  [KEY_LAYER_DIGITS] = {
+    {KEY1,          KEY2,         KEY3},
+    {KEY4,          KEY5,         KEY6},
+    {KEY7,          KEY8,         KEY9},
+    {KEY_ASTERISK,  KEY0,         KEY_HASH},
+  },
+  [KEY_LAYER_NAVIGATION] = {
+    {KEY1,          KEY_NAV_UP,   KEY3},
+    {KEY_NAV_LEFT,  KEY_ENTER,    KEY_NAV_RIGHT},
+    {KEY7,          KEY_NAV_DOWN, KEY9},
+    {KEY_BACK,      KEY0,         KEY_ENTER},
+  },
+};
+
+// last column output isn't connected
+#define KEYS_MAP(layer, col, row) ((col) < 3 ? keymap[layer][row][col] : KEY_NONE)
+
+#else
+  #error "Unknown keypad!"
+#endif
 
 /**
- * Key structure typedef.
+ * @brief Characters of digit keys for multi-tap text entry.
+ */
+static const char* const keyChars[] = {
+  [KEY0] = " 0",
+  [KEY1] = ".,?!1",
+  [KEY2] = "abc2",
+  [KEY3] = "def3",
+  [KEY4] = "ghi4",
+  [KEY5] = "jkl5",
+  [KEY6] = "mno6",
+  [KEY7] = "pqrs7",
+  [KEY8] = "tuv8",
+  [KEY9] = "wxyz9",
+};
+
+/*
+ * Event queue - written only in the interrupt (head) and read
+ * only by the application (tail), so it needs no locking.
  */
-typedef struct {
-	uint8_t id;		///< KEY_ID
-	void (*PressCallback)(void);
-	void (*RepeatCallback)(void);
-	uint16_t len;	///<
-	uint16_t count;	///<
-} KEY_TypeDef;
+static volatile KEY_Event_Typedef events[KEYS_QUEUE_LEN]; ///< Event queue
+static volatile uint8_t eventHead;                        ///< Next free event
+static volatile uint8_t eventTail;                        ///< Oldest event
+static volatile uint16_t eventsLost;                      ///< Events dropped on full queue
 
+static void KEYS_Tick(void);
+static uint8_t KEYS_Debounce(uint16_t raw);
+static void KEYS_HoldEvents(uint8_t i);
+static void KEYS_PushEvent(uint8_t type, uint8_t i);
 
+#ifdef KEYS_USE_EXTI
 
-uint8_t currentColumn; ///< Selected keyboard column
+/**
+ * @brief Starts scanning - called from the row interrupt.
+ */
+static void KEYS_PressCallback(void) {
 
+  currentColumn = 0;
+  rawState = 0;
+  KEYS_HAL_SelectColumn(0);
+  KEYS_HAL_StartTimer(KEYS_SCAN_PERIOD, KEYS_Tick);
+}
+
+#endif
+
+/**
+ * @brief Initialize the keyboard and start scanning.
+ * @details Without KEYS_USE_EXTI the keyboard is scanned all the
+ * time, otherwise only from a press until all keys are released.
+ */
 void KEYS_Init(void) {
 
   KEYS_HAL_Init();
   currentColumn = 0;
+  rawState = 0;
+  keysState = 0;
+  keysLayer = KEY_LAYER_DIGITS;
+  eventHead = 0;
+  eventTail = 0;
+  eventsLost = 0;
 
-  // select first column as default
-  KEYS_HAL_SelectColumn(0);
+  uint8_t i;
+  for (i = 0; i < KEYS_COUNT; i++) {
+    integrators[i] = 0;
+    holdTime[i] = 0;
+  }
 
+#ifdef KEYS_USE_EXTI
+  // nothing to scan until a key is pressed
+  KEYS_HAL_Idle(KEYS_PressCallback);
+#elif defined(KEYS_USE_DMA)
+  // columns are driven by DMA, timer only runs the debounce
+  KEYS_HAL_StartTimer(KEYS_PASS_TIME, KEYS_Tick);
+#else
+  KEYS_HAL_SelectColumn(0);
+  KEYS_HAL_StartTimer(KEYS_SCAN_PERIOD, KEYS_Tick);
+#endif
+}
+/**
+ * @brief Returns all pressed keys.
+ * @details Any number of keys can be pressed at the same time.
+ * Without diodes in the keypad three keys in the corners of
+ * a rectangle also make the fourth one look pressed.
+ * @return Debounced keys - bit (column * KEYS_ROWS + row) is set
+ * for a pressed key
+ */
+uint16_t KEYS_GetState(void) {
+  return keysState;
 }
+/**
+ * @brief Takes the oldest key event from the queue.
+ * @param event Event is written here
+ * @retval 1 Got an event
+ * @retval 0 No events
+ */
+uint8_t KEYS_GetEvent(KEY_Event_Typedef* event) {
+
+  uint8_t tail = eventTail;
+
+  if (tail == eventHead) {
+    return 0;
+  }
+
+  event->type = events[tail].type;
+  event->key  = events[tail].key;
+  event->code = events[tail].code;
+  event->time = events[tail].time;
+
+  eventTail = (tail + 1) & (KEYS_QUEUE_LEN - 1); // free the event after copying
 
+  return 1;
+}
 /**
- * @brief Checks if any keys are set.
- * @details Run this function in main loop to check for pressed keys.
- * TODO Add repeat, function calling
+ * @brief Checks for pressed keys.
+ * @details Simple alternative to KEYS_GetEvent - takes events
+ * from the same queue and returns presses and repeats only.
+ * Run this function in main loop.
+ * @return Key (KEY_Id_Typedef) or KEY_NONE
  */
 uint8_t KEYS_Update(void) {
 
-  static uint8_t keyId = KEY_NONE;
-  uint8_t keyValid = KEY_NONE; // hold a valid debounced key ID
-  uint8_t currentKey = KEY_NONE;
+  KEY_Event_Typedef event;
+  uint16_t lost = eventsLost; // the interrupt may add more meanwhile
+
+  if (lost) {
+    println("Lost %d events!", (int)lost);
+    KEYS_HAL_Lock(); // events are pushed in the timer interrupt
+    eventsLost -= lost;
+    KEYS_HAL_Unlock();
+  }
 
-  static uint32_t debounceTimer = 0; // timer for counting debounce time
+  while (KEYS_GetEvent(&event)) {
+    if (event.type == KEY_DOWN || event.type == KEY_REPEAT) {
+      return event.key;
+    }
+  }
 
-  int8_t row = KEYS_HAL_ReadRow();
+  return KEY_NONE;
+}
+/**
+ * @brief Changes the keymap layer.
+ * @details Keys already pressed keep their meaning until released.
+ * @param layer New layer
+ */
+void KEYS_SetLayer(KEY_Layer_Typedef layer) {
 
-  // if a keypress has been recongized
-  if (row != -1) {
-    currentKey = (currentColumn << 4) | row;
-//    println("You pressed a key in row %d, column %d.", row, currentColumn);
+  if (layer >= KEY_LAYERS) {
+    println("Wrong layer %d!", (int)layer);
+    return;
   }
+  keysLayer = layer;
+}
+/**
+ * @brief Returns the active keymap layer.
+ * @return Layer
+ */
+KEY_Layer_Typedef KEYS_GetLayer(void) {
+  return keysLayer;
+}
+/**
+ * @brief Returns characters of a key for multi-tap text entry.
+ * @details Every tap of the key selects the next character,
+ * e.g. KEY2 - "abc2".
+ * @param key Key
+ * @return Characters or NULL if the key has none
+ */
+const char* KEYS_GetChars(uint8_t key) {
+
+  if (key >= sizeof(keyChars)/sizeof(keyChars[0])) {
+    return NULL;
+  }
+  return keyChars[key];
+}
+/**
+ * @brief Scans one column - called from the timer interrupt.
+ */
+static void KEYS_Tick(void) {
+
+#ifdef KEYS_USE_DMA
+  // DMA has already scanned all columns
+  KEYS_Debounce(KEYS_HAL_ReadMatrix());
+#else
+  // rows of the column selected in the previous tick
+  rawState |= KEYS_HAL_ReadRows() << (currentColumn * KEYS_ROWS);
+
+  if (++currentColumn < KEYS_COLUMNS) {
+    KEYS_HAL_SelectColumn(currentColumn);
+    return;
+  }
+
+  uint8_t busy = KEYS_Debounce(rawState);
+
+  currentColumn = 0;
+  rawState = 0;
 
-  // if key value changed start debounce timer for new key
-  if (keyId != currentKey && currentKey != KEY_NONE) {
-    keyId = currentKey;
-    debounceTimer = TIMER_GetTime();
+#ifdef KEYS_USE_EXTI
+  if (!busy) { // all keys released and settled
+    KEYS_HAL_StopTimer();
+    KEYS_HAL_Idle(KEYS_PressCallback);
+    return;
   }
-  // if debounce finished, the key is valid
-  if (keyId != KEY_NONE && TIMER_DelayTimer(DEBOUNCE_TIME, debounceTimer)) {
-    keyValid = keyId;
-    println("You pressed a key 0x%02x.", keyValid);
-    keyId = KEY_NONE;
+#else
+  (void)busy;
+#endif
+
+  KEYS_HAL_SelectColumn(0);
+#endif /* KEYS_USE_DMA */
+}
+/**
+ * @brief Updates the debounce counters after a full pass.
+ * @param raw Keys seen in the pass (bit per key)
+ * @retval 1 Some keys are pressed or bouncing
+ * @retval 0 All keys released
+ */
+static uint8_t KEYS_Debounce(uint16_t raw) {
+
+  uint16_t state = keysState;
+  uint8_t busy = 0;
+
+  uint8_t i;
+  for (i = 0; i < KEYS_COUNT; i++) {
+
+    uint16_t bit = 1 << i;
+
+    if (raw & bit) {
+      if (integrators[i] < KEYS_DEBOUNCE && ++integrators[i] == KEYS_DEBOUNCE) {
+        state |= bit;
+        holdTime[i] = 0;
+        keysPressed[i] = KEYS_MAP(keysLayer, i / KEYS_ROWS, i % KEYS_ROWS);
+        KEYS_PushEvent(KEY_DOWN, i);
+      }
+    } else {
+      if (integrators[i] && --integrators[i] == 0) {
+        state &= ~bit;
+        KEYS_PushEvent(KEY_UP, i);
+      }
+    }
+    if (state & bit) {
+      KEYS_HoldEvents(i);
+    }
+    busy |= integrators[i];
   }
 
-  // update column
-  currentColumn++;
+  keysState = state;
 
-  if (currentColumn == 4) {
-    currentColumn = 0;
+  return busy != 0;
+}
+/**
+ * @brief Generates long press and repeat events of a held key.
+ * @param i Key index
+ */
+static void KEYS_HoldEvents(uint8_t i) {
+
+  if (holdTime[i] == UINT16_MAX) {
+    return; // held for minutes - no more events
   }
 
-  KEYS_HAL_SelectColumn(currentColumn);
+  uint16_t t = ++holdTime[i];
 
-  // if key is valid return ID, if not returns KEY_NONE
-  return keyValid;
+#if KEYS_LONG_TIME
+  if (t == KEYS_PASSES(KEYS_LONG_TIME)) {
+    KEYS_PushEvent(KEY_LONG, i);
+  }
+#endif
+#if KEYS_REPEAT_RATE
+  if (t >= KEYS_PASSES(KEYS_REPEAT_DELAY) &&
+      (t - KEYS_PASSES(KEYS_REPEAT_DELAY)) % KEYS_PASSES(KEYS_REPEAT_RATE) == 0) {
+    KEYS_PushEvent(KEY_REPEAT, i);
+  }
+#endif
 }
+/**
+ * @brief Adds an event to the queue (called in interrupt).
+ * @details Event is dropped if the queue is full.
+ * @param type Event type
+ * @param i Key index
+ */
+static void KEYS_PushEvent(uint8_t type, uint8_t i) {
+
+  uint8_t head = eventHead;
+  uint8_t next = (head + 1) & (KEYS_QUEUE_LEN - 1);
 
+  if (next == eventTail) {
+    eventsLost++;
+    return;
+  }
+
+  events[head].type = type;
+  events[head].key  = keysPressed[i];
+  events[head].code = ((i / KEYS_ROWS) << 4) | (i % KEYS_ROWS);
+  events[head].time = TIMER_GetTime();
 
+  eventHead = next; // publish after the event is written
+}
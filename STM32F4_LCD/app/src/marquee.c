@@ -0,0 +1,222 @@
+/**
+ * @file:   marquee.c
+ * @brief:  Scrolling text on the LCD
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * A marquee is a window on the display showing a text longer
+ * than the window. All marquees are advanced from one soft timer,
+ * so the application doesn't have to drive the timing.
+ *
+ * Every step the window is redrawn with LCD_Write, which sends
+ * only the characters that changed. Hardware display shift isn't
+ * used - it moves all rows at once and can't scroll a text longer
+ * than a DDRAM line.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <marquee.h>
+#include <hd44780.h>
+#include <timers.h>
+#include <stdio.h>
+#include <string.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) printf("MARQUEE--> "str"%s",##args,"\r")
+  #define println(str, args...) printf("MARQUEE--> "str"%s",##args,"\r\n")
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+/**
+ * @addtogroup MARQUEE
+ * @{
+ */
+
+#define MAX_MARQUEES    4   ///< Maximum number of marquees
+#define MARQUEE_TICK    50  ///< Period of the marquee timer in ms
+#define MARQUEE_GAP     4   ///< Spaces between end and beginning of the text
+#define MARQUEE_WIDTH   40  ///< Maximum width of a marquee window
+
+/**
+ * @brief Marquee structure.
+ */
+typedef struct {
+  const char* text;   ///< Scrolled text
+  uint16_t len;       ///< Length of text
+  uint16_t offset;    ///< Index of text character at left edge of window
+  uint16_t step;      ///< Number of ticks between steps
+  uint16_t ticks;     ///< Ticks since last step
+  uint8_t x;          ///< Column of window
+  uint8_t y;          ///< Row of window
+  uint8_t width;      ///< Width of window
+  uint8_t display;    ///< Display showing the marquee
+  uint8_t active;     ///< Is marquee used?
+} MARQUEE_TypeDef;
+
+static MARQUEE_TypeDef marquees[MAX_MARQUEES]; ///< Array of marquees
+
+static void MARQUEE_Draw(MARQUEE_TypeDef* m);
+static void MARQUEE_TimerCallback(void);
+
+/**
+ * @brief Initialize the marquee engine.
+ * @details Call after TIMER_Init.
+ */
+void MARQUEE_Init(void) {
+
+  int16_t timerId = TIMER_AddSoftTimer(MARQUEE_TICK, MARQUEE_TimerCallback);
+
+  if (timerId < 0) {
+    println("Can't add timer!");
+    return;
+  }
+
+  TIMER_StartSoftTimer(timerId);
+}
+/**
+ * @brief Adds a marquee on the selected display.
+ * @details Text that fits in the window is shown without scrolling.
+ * @param positionX Column of the window
+ * @param positionY Row of the window
+ * @param width Width of the window
+ * @param text Text to show (has to stay valid while it is shown)
+ * @param stepTime Time in ms between steps of one character
+ * @return Marquee ID or error code (-1)
+ * @retval -1 Error: too many marquees or wrong window
+ */
+int8_t MARQUEE_Add(uint8_t positionX, uint8_t positionY, uint8_t width,
+    const char* text, uint16_t stepTime) {
+
+  if (width == 0 || width > MARQUEE_WIDTH) {
+    println("Wrong width!");
+    return -1;
+  }
+
+  uint8_t i;
+  for (i = 0; i < MAX_MARQUEES; i++) {
+
+    if (!marquees[i].active) {
+
+      marquees[i].x     = positionX;
+      marquees[i].y     = positionY;
+      marquees[i].width = width;
+      marquees[i].display = LCD_GetSelected();
+      marquees[i].step  = (stepTime + MARQUEE_TICK - 1) / MARQUEE_TICK;
+      if (marquees[i].step == 0) {
+        marquees[i].step = 1;
+      }
+      marquees[i].active = 1;
+      MARQUEE_SetText(i, text);
+
+      return i;
+    }
+  }
+
+  println("Reached maximum number of marquees!");
+  return -1;
+}
+/**
+ * @brief Changes text of a marquee and starts from its beginning.
+ * @param id Marquee ID
+ * @param text New text (has to stay valid while it is shown)
+ */
+void MARQUEE_SetText(uint8_t id, const char* text) {
+
+  if (id >= MAX_MARQUEES || !marquees[id].active) {
+    println("Wrong marquee ID %d!", (int)id);
+    return;
+  }
+
+  marquees[id].text   = text;
+  marquees[id].len    = strlen(text);
+  marquees[id].offset = 0;
+  marquees[id].ticks  = 0;
+
+  MARQUEE_Draw(&marquees[id]);
+}
+/**
+ * @brief Stops a marquee and frees it (text stays on display).
+ * @param id Marquee ID
+ */
+void MARQUEE_Remove(uint8_t id) {
+
+  if (id >= MAX_MARQUEES) {
+    println("Wrong marquee ID %d!", (int)id);
+    return;
+  }
+
+  marquees[id].active = 0;
+}
+/**
+ * @brief Draws the current window of a marquee.
+ * @param m Marquee
+ */
+static void MARQUEE_Draw(MARQUEE_TypeDef* m) {
+
+  char buf[MARQUEE_WIDTH];
+  uint16_t period = m->len + MARQUEE_GAP; // length of the virtual line
+  uint16_t idx = m->offset;
+  uint8_t i;
+
+  for (i = 0; i < m->width; i++) {
+
+    if (m->len <= m->width) { // fits - no scrolling
+      buf[i] = (i < m->len) ? m->text[i] : ' ';
+      continue;
+    }
+
+    buf[i] = (idx < m->len) ? m->text[idx] : ' ';
+    if (++idx == period) {
+      idx = 0;
+    }
+  }
+
+  LCD_Display_TypeDef selected = LCD_GetSelected();
+
+  LCD_Select(m->display);
+  LCD_Write(m->x, m->y, buf, m->width);
+  LCD_Select(selected);
+}
+/**
+ * @brief Advances all marquees - called by soft timer.
+ */
+static void MARQUEE_TimerCallback(void) {
+
+  uint8_t i;
+  for (i = 0; i < MAX_MARQUEES; i++) {
+
+    MARQUEE_TypeDef* m = &marquees[i];
+
+    if (!m->active || m->len <= m->width) {
+      continue;
+    }
+    if (++m->ticks < m->step) {
+      continue;
+    }
+
+    m->ticks = 0;
+    if (++m->offset == m->len + MARQUEE_GAP) {
+      m->offset = 0;
+    }
+    MARQUEE_Draw(m);
+  }
+}
+
+/**
+ * @}
+ */
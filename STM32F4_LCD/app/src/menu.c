@@ -0,0 +1,240 @@
+/**
+ * @file:   menu.c
+ * @brief:  Hierarchical LCD menu
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Menus are constant tables of items, each leading to a submenu
+ * or calling an action. The menu takes the whole display of the
+ * selected LCD: an optional title in the first row and a window
+ * of items, the selected one marked with '>'. Scrolling and rows
+ * are the same as of the list widget (see widget.c).
+ *
+ * Every key marks only the rows it changes - moving inside the
+ * window changes two rows, scrolling or entering a menu changes
+ * all of them - and these rows are queued to the LCD at once
+ * through LCD_Write (which skips unchanged characters). A key
+ * reaches the screen with the next LCD_Update calls.
+ *
+ * Keypad codes are mapped to MENU_Key_TypeDef by the application.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <menu.h>
+#include <hd44780.h>
+#include <widget.h>
+#include <stdio.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) printf("MENU--> "str"%s",##args,"\r")
+  #define println(str, args...) printf("MENU--> "str"%s",##args,"\r\n")
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+/**
+ * @addtogroup MENU
+ * @{
+ */
+
+#define MENU_MAX_DEPTH  8     ///< Maximum nesting of menus
+#define MENU_WIDTH      40    ///< Maximum width of a row
+#define MENU_ALL_ROWS   0xff  ///< Mask of all rows
+
+/**
+ * @brief Position in one level of menus.
+ */
+typedef struct {
+  const MENU_TypeDef* menu; ///< Menu shown
+  uint8_t selected;         ///< Selected item
+  uint8_t top;              ///< First visible item
+} MENU_Level_TypeDef;
+
+static MENU_Level_TypeDef levels[MENU_MAX_DEPTH]; ///< Path from the root menu
+static uint8_t depth;                             ///< Current level
+static uint8_t display;                           ///< Display showing the menu
+static uint8_t columns;                           ///< Columns of the display
+static uint8_t rows;                              ///< Rows of the display
+static uint8_t dirtyRows;                         ///< Rows to redraw (bit mask)
+
+static uint8_t MENU_FirstRow(const MENU_TypeDef* menu);
+static void MENU_Select(uint8_t item);
+static void MENU_Draw(void);
+
+/**
+ * @brief Initialize the menu and show it on the selected display.
+ * @param root Main menu
+ */
+void MENU_Init(const MENU_TypeDef* root) {
+
+  if (root == NULL || root->count == 0) {
+    println("Empty menu!");
+    return;
+  }
+
+  display = LCD_GetSelected();
+  columns = LCD_GetColumns();
+  rows = LCD_GetRows();
+  depth = 0;
+
+  if (columns > MENU_WIDTH) {
+    columns = MENU_WIDTH;
+  }
+
+  levels[0].menu = root;
+  levels[0].selected = 0;
+  levels[0].top = 0;
+
+  MENU_Redraw();
+}
+/**
+ * @brief Handles a navigation key.
+ * @param key Key
+ */
+void MENU_Key(MENU_Key_TypeDef key) {
+
+  MENU_Level_TypeDef* level = &levels[depth];
+
+  if (level->menu == NULL) {
+    return; // not initialized
+  }
+
+  const MENU_Item_TypeDef* item = &level->menu->items[level->selected];
+
+  switch (key) {
+  case MENU_UP: // wraps around
+    MENU_Select(level->selected ? level->selected - 1 : level->menu->count - 1);
+    break;
+  case MENU_DOWN:
+    MENU_Select(level->selected + 1 < level->menu->count ? level->selected + 1 : 0);
+    break;
+  case MENU_ENTER:
+    if (item->submenu && item->submenu->count) {
+      if (depth + 1 >= MENU_MAX_DEPTH) {
+        println("Menu nested too deep!");
+        break;
+      }
+      depth++;
+      levels[depth].menu = item->submenu;
+      levels[depth].selected = 0;
+      levels[depth].top = 0;
+      dirtyRows = MENU_ALL_ROWS;
+    } else if (item->action) {
+      item->action();
+    }
+    break;
+  case MENU_BACK:
+    if (depth) {
+      depth--;
+      dirtyRows = MENU_ALL_ROWS;
+    }
+    break;
+  }
+
+  MENU_Draw();
+}
+/**
+ * @brief Draws the whole menu again.
+ * @details Call after something else was shown on the display.
+ */
+void MENU_Redraw(void) {
+
+  dirtyRows = MENU_ALL_ROWS;
+  MENU_Draw();
+}
+/**
+ * @brief Returns the selected item of the current menu.
+ * @return Item index
+ */
+uint8_t MENU_GetItem(void) {
+  return levels[depth].selected;
+}
+/**
+ * @brief Returns the first row of items.
+ * @param menu Menu
+ * @return 1 if the title is shown, 0 otherwise
+ */
+static uint8_t MENU_FirstRow(const MENU_TypeDef* menu) {
+  return (menu->title && rows > 1) ? 1 : 0;
+}
+/**
+ * @brief Moves the selection and marks changed rows.
+ * @param item New selected item
+ */
+static void MENU_Select(uint8_t item) {
+
+  MENU_Level_TypeDef* level = &levels[depth];
+  uint8_t first = MENU_FirstRow(level->menu);
+  uint8_t window = rows - first; // visible items
+
+  if (item == level->selected) {
+    return;
+  }
+
+  uint8_t top = WIDGET_ListTop(level->top, item, window);
+
+  if (top != level->top) {
+    level->top = top;
+    dirtyRows = MENU_ALL_ROWS;
+  } else { // only the markers move
+    dirtyRows |= 1 << (first + level->selected - level->top);
+    dirtyRows |= 1 << (first + item - level->top);
+  }
+
+  level->selected = item;
+}
+/**
+ * @brief Draws the rows marked as changed.
+ */
+static void MENU_Draw(void) {
+
+  MENU_Level_TypeDef* level = &levels[depth];
+  char buf[MENU_WIDTH];
+
+  LCD_Display_TypeDef selected = LCD_GetSelected();
+  uint8_t first = MENU_FirstRow(level->menu);
+
+  LCD_Select(display);
+
+  uint8_t row;
+  for (row = 0; row < rows; row++) {
+
+    if (!(dirtyRows & (1 << row))) {
+      continue;
+    }
+
+    uint8_t item = level->top + row - first;
+
+    if (row < first) {
+      WIDGET_FormatRow(buf, columns, WIDGET_ROW_TEXT, level->menu->title);
+    } else if (item < level->menu->count) {
+      WIDGET_FormatRow(buf, columns, item == level->selected ?
+          WIDGET_ROW_SELECTED : WIDGET_ROW_ITEM, level->menu->items[item].label);
+    } else {
+      WIDGET_FormatRow(buf, columns, WIDGET_ROW_TEXT, NULL);
+    }
+
+    LCD_Write(0, row, buf, columns);
+  }
+
+  dirtyRows = 0;
+  LCD_Select(selected);
+}
+
+/**
+ * @}
+ */
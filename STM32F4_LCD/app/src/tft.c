@@ -0,0 +1,599 @@
+/**
+ * @file:   tft.c
+ * @brief:  SPI TFT display driver (ILI9341, ST7735)
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Drawing is done in jobs - a window (column and row address
+ * set) filled with pixels by DMA. Jobs wait in a queue and the
+ * next one is started from the interrupt of the previous one,
+ * so drawing functions return at once. A rectangle is one job
+ * sending a single color repeatedly. Characters next to each
+ * other in a row (up to TFT_MAX_BATCH) are one job with the
+ * pixels of their cells rendered into a buffer of the job.
+ * The CPU never waits - when the queue is full, drawing fails
+ * (text isn't marked as drawn, so TFT_Write draws it again).
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <tft.h>
+#include <tft_hal.h>
+#include <font.h>
+#include <timers.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+
+#ifdef TFT_ENABLE // see tft_hal.h
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) printf("TFT--> "str"%s",##args,"\r")
+  #define println(str, args...) printf("TFT--> "str"%s",##args,"\r\n")
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+/**
+ * @addtogroup TFT
+ * @{
+ */
+
+/*
+ * Commands common to ILI9341 and ST7735
+ */
+#define TFT_SWRESET 0x01 ///< Software reset
+#define TFT_SLPOUT  0x11 ///< Sleep out
+#define TFT_DISPON  0x29 ///< Display on
+#define TFT_CASET   0x2a ///< Column address set
+#define TFT_RASET   0x2b ///< Row address set
+#define TFT_RAMWR   0x2c ///< Memory write
+#define TFT_MADCTL  0x36 ///< Memory access control
+#define TFT_COLMOD  0x3a ///< Pixel format
+
+/*
+ * Initialization sequences: command, number of parameters
+ * (ORed with TFT_DELAY if a delay in ms follows them),
+ * parameters, delay. TFT_END ends the sequence.
+ */
+#define TFT_DELAY 0x80 ///< Delay after command
+#define TFT_END   0xff ///< End of sequence
+
+static const uint8_t ili9341Init[] = {
+  TFT_SWRESET, TFT_DELAY, 150,
+  TFT_SLPOUT,  TFT_DELAY, 120,
+  TFT_COLMOD,  1, 0x55,         // 16 bits per pixel
+  TFT_MADCTL,  1, 0x48,         // portrait, BGR
+  TFT_DISPON,  0,
+  TFT_END
+};
+
+static const uint8_t st7735Init[] = {
+  TFT_SWRESET, TFT_DELAY, 150,
+  TFT_SLPOUT,  TFT_DELAY, 150,
+  TFT_COLMOD,  1, 0x05,         // 16 bits per pixel
+  TFT_MADCTL,  1, 0xc8,         // portrait, BGR
+  TFT_DISPON,  0,
+  TFT_END
+};
+
+/**
+ * @brief Controller descriptor.
+ */
+typedef struct {
+  uint16_t width;       ///< Width in pixels
+  uint16_t height;      ///< Height in pixels
+  const uint8_t* init;  ///< Initialization sequence
+} TFT_ControllerDesc_TypeDef;
+
+/**
+ * @brief Descriptors of supported controllers (indexed by TFT_Controller_TypeDef).
+ */
+static const TFT_ControllerDesc_TypeDef tftControllers[] = {
+  [TFT_ILI9341] = {240, 320, ili9341Init},
+  [TFT_ST7735]  = {128, 160, st7735Init},
+};
+
+#define TFT_MAX_JOBS    16  ///< Length of the job queue
+#define TFT_MAX_BATCH   8   ///< Maximum number of characters of one job
+#define TFT_CELL_PIXELS (FONT_CELL_WIDTH * FONT_CELL_HEIGHT) ///< Pixels of a character
+#define TFT_WINDOW_LEN  14  ///< Bytes of the window commands
+#define TFT_MAX_COLUMNS 40  ///< Maximum number of text columns
+#define TFT_MAX_ROWS    40  ///< Maximum number of text rows
+
+/**
+ * @brief Drawing job.
+ */
+typedef struct {
+  uint16_t x0;              ///< First column of the window
+  uint16_t y0;              ///< First row of the window
+  uint16_t x1;              ///< Last column of the window
+  uint16_t y1;              ///< Last row of the window
+  const uint16_t* pixels;   ///< Pixels of the window (NULL - fill with color)
+  uint16_t color;           ///< Fill color
+} TFT_Job_TypeDef;
+
+static TFT_Job_TypeDef jobs[TFT_MAX_JOBS];  ///< Job queue
+static uint16_t cells[TFT_MAX_JOBS][TFT_MAX_BATCH * TFT_CELL_PIXELS]; ///< Character pixels of each job
+static uint8_t window[TFT_WINDOW_LEN];      ///< Window commands of the job being sent
+static uint8_t jobHead;                     ///< Next free job
+static uint8_t jobTail;                     ///< Job being sent
+static volatile uint8_t jobCount;           ///< Jobs in the queue
+
+static const TFT_ControllerDesc_TypeDef* tft; ///< Controller in use
+static uint16_t foreground = TFT_WHITE;       ///< Text color
+static uint16_t background = TFT_BLACK;       ///< Background color
+
+static uint8_t columns;                                 ///< Number of text columns
+static uint8_t rows;                                    ///< Number of text rows
+static uint8_t shadow[TFT_MAX_COLUMNS * TFT_MAX_ROWS];  ///< Characters on the display
+static uint8_t cursorX;                                 ///< Current column
+static uint8_t cursorY;                                 ///< Current row
+
+static TFT_Job_TypeDef* TFT_NewJob(void);
+static void TFT_CommitJob(void);
+static void TFT_StartJob(void);
+static void TFT_JobDone(void);
+static uint8_t TFT_DrawChars(uint8_t positionX, uint8_t positionY,
+    const char* s, uint8_t len);
+
+/**
+ * @brief Initialize the display.
+ * @param controller Controller of the display
+ * @warning This is a blocking function (can last about 500ms) - only called once though
+ */
+void TFT_Init(TFT_Controller_TypeDef controller) {
+
+  if (controller >= sizeof(tftControllers)/sizeof(tftControllers[0])) {
+    println("Wrong controller!");
+    return;
+  }
+  tft = &tftControllers[controller];
+
+  TFT_HAL_Init(TFT_JobDone);
+  TIMER_Delay(120); // wait after hardware reset
+
+  const uint8_t* p = tft->init;
+
+  while (*p != TFT_END) {
+
+    uint8_t command = *p++;
+    uint8_t len = *p & ~TFT_DELAY;
+    uint8_t delay = *p++ & TFT_DELAY;
+
+    TFT_HAL_Command(command, p, len);
+    p += len;
+
+    if (delay) {
+      TIMER_Delay(*p++);
+    }
+  }
+
+  columns = tft->width / FONT_CELL_WIDTH;
+  rows = tft->height / FONT_CELL_HEIGHT;
+
+  TFT_Clear();
+}
+/**
+ * @brief Checks if drawing is still in progress.
+ * @retval 1 Jobs are waiting or being sent
+ * @retval 0 Everything was drawn
+ */
+uint8_t TFT_IsBusy(void) {
+  return jobCount != 0;
+}
+/**
+ * @brief Returns the width of the display.
+ * @return Width in pixels
+ */
+uint16_t TFT_GetWidth(void) {
+  return tft->width;
+}
+/**
+ * @brief Returns the height of the display.
+ * @return Height in pixels
+ */
+uint16_t TFT_GetHeight(void) {
+  return tft->height;
+}
+/**
+ * @brief Fills a rectangle with a color.
+ * @param x Left column
+ * @param y Top row
+ * @param w Width
+ * @param h Height
+ * @param color Color (RGB565)
+ * @retval 0 Rectangle queued
+ * @retval -1 Wrong rectangle or queue full
+ */
+int8_t TFT_FillRect(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+    uint16_t color) {
+
+  if (w == 0 || h == 0 || x + w > tft->width || y + h > tft->height) {
+    println("Wrong rectangle!");
+    return -1;
+  }
+
+  TFT_Job_TypeDef* job = TFT_NewJob();
+  if (job == NULL) {
+    return -1;
+  }
+
+  job->x0 = x;
+  job->y0 = y;
+  job->x1 = x + w - 1;
+  job->y1 = y + h - 1;
+  job->pixels = NULL;
+  job->color = color;
+
+  TFT_CommitJob();
+
+  return 0;
+}
+/**
+ * @brief Draws a bitmap.
+ * @param x Left column
+ * @param y Top row
+ * @param w Width
+ * @param h Height
+ * @param pixels w*h pixels (RGB565, row by row) - have to stay
+ * valid until drawn (see TFT_IsBusy)
+ * @retval 0 Bitmap queued
+ * @retval -1 Wrong rectangle or queue full
+ */
+int8_t TFT_DrawBitmap(uint16_t x, uint16_t y, uint16_t w, uint16_t h,
+    const uint16_t* pixels) {
+
+  if (w == 0 || h == 0 || x + w > tft->width || y + h > tft->height) {
+    println("Wrong rectangle!");
+    return -1;
+  }
+
+  TFT_Job_TypeDef* job = TFT_NewJob();
+  if (job == NULL) {
+    return -1;
+  }
+
+  job->x0 = x;
+  job->y0 = y;
+  job->x1 = x + w - 1;
+  job->y1 = y + h - 1;
+  job->pixels = pixels;
+
+  TFT_CommitJob();
+
+  return 0;
+}
+/**
+ * @brief Sets colors of the text drawn next.
+ * @param fg Text color
+ * @param bg Background color
+ */
+void TFT_SetColors(uint16_t fg, uint16_t bg) {
+  foreground = fg;
+  background = bg;
+}
+/**
+ * @brief Returns the number of text columns.
+ * @return Number of columns
+ */
+uint8_t TFT_GetColumns(void) {
+  return columns;
+}
+/**
+ * @brief Returns the number of text rows.
+ * @return Number of rows
+ */
+uint8_t TFT_GetRows(void) {
+  return rows;
+}
+/**
+ * @brief Moves the cursor to the first character.
+ */
+void TFT_Home(void) {
+  cursorX = 0;
+  cursorY = 0;
+}
+/**
+ * @brief Sets the position of the next character.
+ * @param positionX Column
+ * @param positionY Row
+ */
+void TFT_Position(uint8_t positionX, uint8_t positionY) {
+
+  if (positionY >= rows || positionX >= columns) {
+    println("Wrong position!");
+    return;
+  }
+  cursorX = positionX;
+  cursorY = positionY;
+}
+/**
+ * @brief Clears the display with the background color.
+ * @details The text stays if the queue is full.
+ */
+void TFT_Clear(void) {
+
+  if (TFT_FillRect(0, 0, tft->width, tft->height, background)) {
+    return;
+  }
+
+  memset(shadow, ' ', sizeof(shadow));
+  TFT_Home();
+}
+/**
+ * @brief Prints a character at the current position.
+ * @details Text wraps to the next row and from the last
+ * row to the first one. The cursor stays if the queue is full.
+ * @param c Character
+ */
+void TFT_Putc(uint8_t c) {
+
+  if (c == '\n') {
+    cursorX = 0;
+    cursorY = (cursorY + 1) % rows;
+    return;
+  }
+
+  char buf[1] = {c};
+  if (TFT_DrawChars(cursorX, cursorY, buf, 1) == 0) {
+    return;
+  }
+
+  if (++cursorX == columns) {
+    cursorX = 0;
+    cursorY = (cursorY + 1) % rows;
+  }
+}
+/**
+ * @brief Prints a string at the current position.
+ * @details Characters up to the end of the row or a new line
+ * are drawn together. Printing stops if the queue is full,
+ * the cursor stays after the last character drawn.
+ * @param s String
+ */
+void TFT_Puts(char* s) {
+
+  while (*s != '\0') {
+
+    if (*s == '\n') {
+      TFT_Putc(*s++);
+      continue;
+    }
+
+    uint8_t len = 0;
+    while (s[len] != '\0' && s[len] != '\n' && len < columns - cursorX) {
+      len++;
+    }
+
+    uint8_t drawn = TFT_DrawChars(cursorX, cursorY, s, len);
+    s += drawn;
+
+    cursorX += drawn;
+    if (cursorX == columns) {
+      cursorX = 0;
+      cursorY = (cursorY + 1) % rows;
+    }
+
+    if (drawn < len) {
+      return; // queue full
+    }
+  }
+}
+/**
+ * @brief Writes text to a region of the display.
+ * @details Only characters that differ from what is already
+ * displayed are drawn, neighbouring ones together. Text is
+ * clipped at the end of the row.
+ * @param positionX Column of the first character
+ * @param positionY Row
+ * @param s Text
+ * @param len Number of characters
+ */
+void TFT_Write(uint8_t positionX, uint8_t positionY, const char* s, uint8_t len) {
+
+  if (positionY >= rows || positionX >= columns) {
+    println("Wrong position!");
+    return;
+  }
+
+  if (len > columns - positionX) {
+    len = columns - positionX;
+  }
+
+  const uint8_t* old = &shadow[positionY * columns + positionX];
+  uint8_t i = 0;
+
+  while (i < len) {
+
+    if (old[i] == (uint8_t)s[i]) {
+      i++;
+      continue;
+    }
+
+    // run of changed characters
+    uint8_t start = i;
+    while (i < len && old[i] != (uint8_t)s[i]) {
+      i++;
+    }
+    if (TFT_DrawChars(positionX + start, positionY, &s[start], i - start) < i - start) {
+      return; // queue full - shadow keeps the rest, next write draws it
+    }
+  }
+}
+/**
+ * @brief Formatted print to a given position.
+ * @details Works like printf, but the output goes through
+ * TFT_Write, so only changed characters are drawn.
+ * @param positionX Column
+ * @param positionY Row
+ * @param fmt Format string
+ * @return Number of characters written (clipped to the row)
+ */
+int TFT_Printf(uint8_t positionX, uint8_t positionY, const char* fmt, ...) {
+
+  char buf[TFT_MAX_COLUMNS + 1];
+  va_list args;
+
+  va_start(args, fmt);
+  int len = vsnprintf(buf, sizeof(buf), fmt, args);
+  va_end(args);
+
+  if (len < 0) {
+    return len;
+  }
+  if (len > columns - positionX) {
+    len = columns - positionX;
+  }
+
+  TFT_Write(positionX, positionY, buf, len);
+
+  return len;
+}
+/**
+ * @brief Draws characters next to each other in a row.
+ * @details Every TFT_MAX_BATCH characters are one job
+ * (one window).
+ * @param positionX Column of the first character
+ * @param positionY Row
+ * @param s Characters
+ * @param len Number of characters (have to fit in the row)
+ * @return Number of characters queued - less than len if the queue is full
+ */
+static uint8_t TFT_DrawChars(uint8_t positionX, uint8_t positionY,
+    const char* s, uint8_t len) {
+
+  uint8_t drawn = 0;
+
+  while (drawn < len) {
+
+    uint8_t count = len - drawn > TFT_MAX_BATCH ? TFT_MAX_BATCH : len - drawn;
+
+    TFT_Job_TypeDef* job = TFT_NewJob();
+    if (job == NULL) {
+      break;
+    }
+
+    uint16_t* cell = cells[job - jobs];
+    uint8_t x, y, i;
+
+    // row by row of the window - one row of each character in turn
+    for (y = 0; y < FONT_CELL_HEIGHT; y++) {
+      for (i = 0; i < count; i++) {
+        const uint8_t* glyph = FONT_GetChar((uint8_t)s[i]);
+        for (x = 0; x < FONT_CELL_WIDTH; x++) {
+          uint8_t on = (x < FONT_WIDTH) && (glyph[x] & (1 << y));
+          *cell++ = on ? foreground : background;
+        }
+      }
+    }
+
+    job->x0 = positionX * FONT_CELL_WIDTH;
+    job->y0 = positionY * FONT_CELL_HEIGHT;
+    job->x1 = job->x0 + count * FONT_CELL_WIDTH - 1;
+    job->y1 = job->y0 + FONT_CELL_HEIGHT - 1;
+    job->pixels = cells[job - jobs];
+
+    TFT_CommitJob();
+
+    memcpy(&shadow[positionY * columns + positionX], s, count);
+
+    positionX += count;
+    s += count;
+    drawn += count;
+  }
+
+  return drawn;
+}
+/**
+ * @brief Returns the next free job.
+ * @return Job to fill in, NULL if the queue is full
+ */
+static TFT_Job_TypeDef* TFT_NewJob(void) {
+
+  if (jobCount == TFT_MAX_JOBS) {
+    println("Queue full!");
+    return NULL;
+  }
+
+  return &jobs[jobHead];
+}
+/**
+ * @brief Adds the job returned by TFT_NewJob to the queue.
+ * @details Starts it if nothing is being sent.
+ */
+static void TFT_CommitJob(void) {
+
+  TFT_HAL_Lock(); // jobs are taken in the interrupt
+
+  jobHead = (jobHead + 1) % TFT_MAX_JOBS;
+
+  if (jobCount++ == 0) {
+    TFT_StartJob();
+  }
+
+  TFT_HAL_Unlock();
+}
+/**
+ * @brief Starts the oldest job.
+ * @details The HAL sends the window commands and the pixels
+ * without waiting.
+ */
+static void TFT_StartJob(void) {
+
+  TFT_Job_TypeDef* job = &jobs[jobTail];
+  uint8_t* p = window;
+
+  *p++ = TFT_CASET;
+  *p++ = 4;
+  *p++ = job->x0 >> 8;
+  *p++ = job->x0;
+  *p++ = job->x1 >> 8;
+  *p++ = job->x1;
+  *p++ = TFT_RASET;
+  *p++ = 4;
+  *p++ = job->y0 >> 8;
+  *p++ = job->y0;
+  *p++ = job->y1 >> 8;
+  *p++ = job->y1;
+  *p++ = TFT_RAMWR;
+  *p++ = 0;
+
+  uint32_t count = (uint32_t)(job->x1 - job->x0 + 1) * (job->y1 - job->y0 + 1);
+
+  if (job->pixels) {
+    TFT_HAL_Pixels(window, sizeof(window), job->pixels, count, 0);
+  } else {
+    TFT_HAL_Pixels(window, sizeof(window), &job->color, count, 1);
+  }
+}
+/**
+ * @brief Called by the HAL (in interrupt) when a job is sent.
+ */
+static void TFT_JobDone(void) {
+
+  jobTail = (jobTail + 1) % TFT_MAX_JOBS;
+
+  if (--jobCount) {
+    TFT_StartJob();
+  }
+}
+
+/**
+ * @}
+ */
+
+#endif /* TFT_ENABLE */
@@ -8,6 +8,15 @@
  * Control of the SysTick and software timers
  * incremented based on SysTick interrupts.
  *
+ * Running soft timers are kept in a list sorted by the time of
+ * overflow, so TIMER_SoftTimersUpdate only looks at the timers
+ * which are due. The price is a walk of the list when a timer is
+ * started or a periodic one is rearmed - O(n) for n running
+ * timers, instead of O(1) of a timing wheel. With the default
+ * MAX_SOFT_TIMERS this is a few dozen comparisons per overflow,
+ * and a wheel would have to catch up on all the ticks missed
+ * between calls from the main loop.
+ *
  * @verbatim
  * Copyright (c) 2014 Michal Ksiezopolski.
  * All rights reserved. This program and the 
@@ -22,15 +31,15 @@
 #include <timers.h>
 #include <stdio.h>
 #include <systick.h>
-#include <timer14.h>
+#include <timer5.h>
 
 #ifndef DEBUG
   #define DEBUG
 #endif
 
 #ifdef DEBUG
-  #define print(str, args...) printf("LED--> "str"%s",##args,"\r")
-  #define println(str, args...) printf("LED--> "str"%s",##args,"\r\n")
+  #define print(str, args...) printf("TIMER--> "str"%s",##args,"\r")
+  #define println(str, args...) printf("TIMER--> "str"%s",##args,"\r\n")
 #else
   #define print(str, args...) (void)0
   #define println(str, args...) (void)0
@@ -41,23 +50,51 @@
  * @{
  */
 
-#define MAX_SOFT_TIMERS 10 ///< Maximum number of soft timers.
+#ifndef MAX_SOFT_TIMERS
+  #define MAX_SOFT_TIMERS 32 ///< Maximum number of soft timers (up to 32767).
+#endif
+
+#define SOFT_TIMER_NONE 0xffff ///< End of the list of running timers
 
-static uint8_t softTimerCount; ///< Count number of soft timers
+/**
+ * @brief Soft timer states.
+ */
+typedef enum {
+  SOFT_TIMER_FREE,    //!< SOFT_TIMER_FREE Slot not used
+  SOFT_TIMER_STOPPED, //!< SOFT_TIMER_STOPPED Added, not counting
+  SOFT_TIMER_RUNNING, //!< SOFT_TIMER_RUNNING In the list of running timers
+  SOFT_TIMER_PAUSED,  //!< SOFT_TIMER_PAUSED Stopped, remembers the time left
+} TIMER_SoftState_TypeDef;
 
 /**
  * @brief Soft timer structure.
  */
 typedef struct {
-  uint8_t id;                     ///< Timer ID
-  uint32_t value;                 ///< Current count value
+  uint32_t expiry;                ///< System time of overflow (running) or time left (paused)
   uint32_t max;                   ///< Overflow value
-  uint8_t active;                 ///< Is timer active?
+  uint8_t state;                  ///< Timer state (TIMER_SoftState_TypeDef)
+  uint8_t mode;                   ///< Periodic or one-shot (TIMER_Mode_TypeDef)
+  uint16_t next;                  ///< Next running timer (sorted by expiry)
   void (*overflowCallback)(void); ///< Function called on overflow event
+  void (*contextCallback)(void*); ///< Function called on overflow event with context
+  void* context;                  ///< Context passed to contextCallback
 } TIMER_Soft_TypeDef;
 
 static TIMER_Soft_TypeDef softTimers[MAX_SOFT_TIMERS]; ///< Array of soft timers
 
+/*
+ * Running timers are kept in a list sorted by the time of overflow,
+ * so TIMER_SoftTimersUpdate only looks at the first timer until
+ * it is due - its cost doesn't depend on the number of timers.
+ * Only starting a timer walks the list.
+ */
+static uint16_t softTimerFirst = SOFT_TIMER_NONE; ///< Running timer which overflows first
+
+static int16_t TIMER_NewSoftTimer(uint32_t maxVal, TIMER_Mode_TypeDef mode);
+static uint8_t TIMER_CheckSoftTimer(uint16_t id);
+static void TIMER_InsertSoftTimer(uint16_t id);
+static void TIMER_RemoveSoftTimer(uint16_t id);
+
 /**
  * @brief Initiate the system time interrupt with a given frequency.
  * @param freq Required frequency of the timer in Hz
@@ -66,8 +103,8 @@ void TIMER_Init(uint32_t freq) {
 
   SYSTICK_Init(freq); // initialize sysTick for ms count
 
-  // initialize TIMER14 as microsecond counter
-  TIMER14_Init();
+  // initialize TIMER5 as microsecond counter
+  TIMER5_Init();
 
 }
 /**
@@ -77,6 +114,13 @@ void TIMER_Init(uint32_t freq) {
 uint32_t TIMER_GetTime(void) {
   return SYSTICK_GetTime();
 }
+/**
+ * @brief Returns the microsecond time.
+ * @return Time in microseconds (overflows every ~71 minutes)
+ */
+uint32_t TIMER_GetTimeUS(void) {
+  return TIMER5_GetTime();
+}
 
 /**
  * @brief Delay function.
@@ -107,18 +151,10 @@ void TIMER_Delay(uint32_t ms) {
  */
 void TIMER_DelayUS(uint32_t us) {
 
-  uint32_t startTime = TIMER14_GetTime();
-  uint32_t currentTime;
+  uint32_t startTime = TIMER5_GetTime();
 
-  while (1) { // Delay
-    currentTime = TIMER14_GetTime();
-    if ((currentTime >= startTime) && (currentTime-startTime > us)) {
-      break;
-    }
-    // account for system timer overflow
-    if ((currentTime < startTime) && (UINT32_MAX-startTime + currentTime > us)) {
-      break;
-    }
+  // unsigned difference is right also when the counter wraps around
+  while (TIMER5_GetTime() - startTime <= us) {
   }
 }
 
@@ -147,96 +183,252 @@ uint8_t TIMER_DelayTimer(uint32_t ms, uint32_t startTime) {
 }
 
 /**
- * @brief Adds a soft timer
+ * @brief Adds a periodic soft timer
  * @param maxVal Overflow value of timer
  * @param fun Function called on overflow (should return void and accept no parameters)
  * @return Returns the ID of the new counter or error code (-1)
  * @retval -1 Error: too many timers
  */
-int8_t TIMER_AddSoftTimer(uint32_t maxVal, void (*fun)(void)) {
+int16_t TIMER_AddSoftTimer(uint32_t maxVal, void (*fun)(void)) {
 
-  if (softTimerCount > MAX_SOFT_TIMERS) {
-    println("TIMERS: Reached maximum number of timers!");
-    return -1;
-  }
+  int16_t id = TIMER_NewSoftTimer(maxVal, TIMER_PERIODIC);
 
-  softTimers[softTimerCount].id = softTimerCount;
-  softTimers[softTimerCount].overflowCallback = fun;
-  softTimers[softTimerCount].max = maxVal;
-  softTimers[softTimerCount].value = 0;
-  softTimers[softTimerCount].active = 0; // inactive on startup
+  if (id >= 0) {
+    softTimers[id].overflowCallback = fun;
+  }
+  return id;
+}
+/**
+ * @brief Adds a soft timer with a callback context
+ * @param maxVal Overflow value of timer
+ * @param mode Periodic or one-shot
+ * @param fun Function called on overflow with the context
+ * @param context Pointer passed to the function (e.g. object which owns the timer)
+ * @return Returns the ID of the new counter or error code (-1)
+ * @retval -1 Error: too many timers
+ */
+int16_t TIMER_CreateSoftTimer(uint32_t maxVal, TIMER_Mode_TypeDef mode,
+    void (*fun)(void*), void* context) {
 
-  softTimerCount++;
+  int16_t id = TIMER_NewSoftTimer(maxVal, mode);
 
-  return (softTimerCount - 1);
+  if (id >= 0) {
+    softTimers[id].contextCallback = fun;
+    softTimers[id].context = context;
+  }
+  return id;
 }
+/**
+ * @brief Deletes a soft timer.
+ * @details The ID is free for new timers afterwards, so the
+ * owner should forget it. A timer can delete itself in its callback.
+ * @param id Timer ID
+ */
+void TIMER_DeleteSoftTimer(uint16_t id) {
 
+  if (!TIMER_CheckSoftTimer(id)) {
+    return;
+  }
+  if (softTimers[id].state == SOFT_TIMER_RUNNING) {
+    TIMER_RemoveSoftTimer(id);
+  }
+  softTimers[id].state = SOFT_TIMER_FREE;
+}
 /**
  * @brief Starts the timer (zeroes out current count value).
+ * @details Starting a running timer restarts it.
  * @param id Timer ID
  */
-void TIMER_StartSoftTimer(uint8_t id) {
+void TIMER_StartSoftTimer(uint16_t id) {
 
-  softTimers[id].value = 0;
-  softTimers[id].active = 1; // start timer
+  if (!TIMER_CheckSoftTimer(id)) {
+    return;
+  }
+  if (softTimers[id].state == SOFT_TIMER_RUNNING) {
+    TIMER_RemoveSoftTimer(id);
+  }
+  softTimers[id].expiry = SYSTICK_GetTime() + softTimers[id].max;
+  softTimers[id].state = SOFT_TIMER_RUNNING; // start timer
+  TIMER_InsertSoftTimer(id);
+}
+/**
+ * @brief Changes the overflow value and starts the timer again.
+ * @param id Timer ID
+ * @param maxVal New overflow value
+ */
+void TIMER_RestartSoftTimer(uint16_t id, uint32_t maxVal) {
+
+  if (!TIMER_CheckSoftTimer(id)) {
+    return;
+  }
+  softTimers[id].max = maxVal;
+  TIMER_StartSoftTimer(id);
+}
+/**
+ * @brief Stops the timer (cancels the overflow).
+ * @param id Timer ID
+ */
+void TIMER_StopSoftTimer(uint16_t id) {
+
+  if (!TIMER_CheckSoftTimer(id)) {
+    return;
+  }
+  if (softTimers[id].state == SOFT_TIMER_RUNNING) {
+    TIMER_RemoveSoftTimer(id);
+  }
+  softTimers[id].state = SOFT_TIMER_STOPPED;
 }
 /**
  * @brief Pauses given timer (current count value unchanged)
  * @param id Timer ID
  */
-void TIMER_PauseSoftTimer(uint8_t id) {
+void TIMER_PauseSoftTimer(uint16_t id) {
 
-  softTimers[id].active = 0; // pause timer
+  if (!TIMER_CheckSoftTimer(id) || softTimers[id].state != SOFT_TIMER_RUNNING) {
+    return;
+  }
+  TIMER_RemoveSoftTimer(id);
+  uint32_t left = softTimers[id].expiry - SYSTICK_GetTime();
+  softTimers[id].expiry = ((int32_t)left > 0) ? left : 0; // keep the time left
+  softTimers[id].state = SOFT_TIMER_PAUSED; // pause timer
 }
 /**
  * @brief Resumes a timer (starts counting from last value).
  * @param id Timer ID
  */
-void TIMER_ResumeSoftTimer(uint8_t id) {
+void TIMER_ResumeSoftTimer(uint16_t id) {
 
-  softTimers[id].active = 1; // start timer
+  if (!TIMER_CheckSoftTimer(id) || softTimers[id].state != SOFT_TIMER_PAUSED) {
+    return;
+  }
+  softTimers[id].expiry += SYSTICK_GetTime(); // time left to time of overflow
+  softTimers[id].state = SOFT_TIMER_RUNNING; // start timer
+  TIMER_InsertSoftTimer(id);
+}
+/**
+ * @brief Checks if a timer is counting.
+ * @param id Timer ID
+ * @retval 1 Timer is running
+ * @retval 0 Timer is stopped, paused, has expired (one-shot) or doesn't exist
+ */
+uint8_t TIMER_IsSoftTimerRunning(uint16_t id) {
+  return id < MAX_SOFT_TIMERS && softTimers[id].state == SOFT_TIMER_RUNNING;
 }
 /**
  * @brief Updates all the timers and calls the overflow functions as
  * necessary
  *
  * @details This function should be called periodically in the main
- * loop of the program.
+ * loop of the program. Only timers which are due are touched.
  */
 void TIMER_SoftTimersUpdate(void) {
 
-  static uint32_t prevVal;
-  uint32_t delta;
   uint32_t sysTicks = SYSTICK_GetTime();
 
-  if (sysTicks >= prevVal) {
+  // times are compared as a difference, so overflow of sysTicks is not a problem
+  while (softTimerFirst != SOFT_TIMER_NONE &&
+      (int32_t)(sysTicks - softTimers[softTimerFirst].expiry) >= 0) {
 
-    delta = sysTicks - prevVal; // How much time passed from previous run
+    uint16_t id = softTimerFirst;
+    softTimerFirst = softTimers[id].next;
 
-  } else { // if overflow occurs
+    if (softTimers[id].mode == TIMER_ONE_SHOT) {
+      softTimers[id].state = SOFT_TIMER_STOPPED;
+    } else {
+      // next overflow - count from now if late more than a period
+      softTimers[id].expiry += softTimers[id].max;
+      if ((int32_t)(sysTicks - softTimers[id].expiry) >= 0) {
+        softTimers[id].expiry = sysTicks + (softTimers[id].max ? softTimers[id].max : 1);
+      }
+      TIMER_InsertSoftTimer(id); // before the callback, so it can stop the timer
+    }
 
-    // the difference is the value that prevVal
-    // has to UINT32_MAX + the new number of sysTicks
-    delta = UINT32_MAX - prevVal + sysTicks;
+    // the callback may delete, restart or add timers
+    if (softTimers[id].overflowCallback != NULL) {
+      softTimers[id].overflowCallback(); // call the overflow function
+    } else if (softTimers[id].contextCallback != NULL) {
+      softTimers[id].contextCallback(softTimers[id].context);
+    }
+  }
+}
+/**
+ * @brief Takes a free slot for a new timer.
+ * @param maxVal Overflow value of timer
+ * @param mode Periodic or one-shot
+ * @return Timer ID or error code (-1)
+ */
+static int16_t TIMER_NewSoftTimer(uint32_t maxVal, TIMER_Mode_TypeDef mode) {
 
+  uint16_t id;
+  for (id = 0; id < MAX_SOFT_TIMERS; id++) {
+    if (softTimers[id].state == SOFT_TIMER_FREE) {
+      break;
+    }
   }
 
-  prevVal += delta; // update time for the function
+  if (id == MAX_SOFT_TIMERS) {
+    println("Reached maximum number of timers!");
+    return -1;
+  }
 
-  uint8_t i;
-  for (i = 0; i < softTimerCount; i++) {
+  softTimers[id].overflowCallback = NULL;
+  softTimers[id].contextCallback = NULL;
+  softTimers[id].context = NULL;
+  softTimers[id].max = maxVal;
+  softTimers[id].expiry = maxVal;
+  softTimers[id].mode = mode;
+  softTimers[id].state = SOFT_TIMER_STOPPED; // inactive on startup
+  softTimers[id].next = SOFT_TIMER_NONE;
 
-    if (softTimers[i].active == 1) {
+  return id;
+}
+/**
+ * @brief Checks the ID of a timer.
+ * @param id Timer ID
+ * @retval 1 Timer exists
+ * @retval 0 Wrong ID
+ */
+static uint8_t TIMER_CheckSoftTimer(uint16_t id) {
 
-      softTimers[i].value += delta; // update active timer values
+  if (id >= MAX_SOFT_TIMERS || softTimers[id].state == SOFT_TIMER_FREE) {
+    println("Wrong timer ID %d!", (int)id);
+    return 0;
+  }
+  return 1;
+}
+/**
+ * @brief Puts a timer into the list of running timers.
+ * @details Timers with the same expiry are kept in start order.
+ * @param id Timer ID
+ */
+static void TIMER_InsertSoftTimer(uint16_t id) {
 
-      if (softTimers[i].value >= softTimers[i].max) { // if overflow
-        softTimers[i].value = 0; // zero out timer
-        if (softTimers[i].overflowCallback != NULL) {
-          softTimers[i].overflowCallback(); // call the overflow function
-        }
-      }
+  uint32_t expiry = softTimers[id].expiry;
+  uint16_t* link = &softTimerFirst;
+
+  while (*link != SOFT_TIMER_NONE &&
+      (int32_t)(softTimers[*link].expiry - expiry) <= 0) {
+    link = &softTimers[*link].next;
+  }
+
+  softTimers[id].next = *link;
+  *link = id;
+}
+/**
+ * @brief Takes a timer out of the list of running timers.
+ * @param id Timer ID
+ */
+static void TIMER_RemoveSoftTimer(uint16_t id) {
+
+  uint16_t* link = &softTimerFirst;
+
+  while (*link != SOFT_TIMER_NONE) {
+    if (*link == id) {
+      *link = softTimers[id].next;
+      softTimers[id].next = SOFT_TIMER_NONE;
+      return;
     }
+    link = &softTimers[*link].next;
   }
 }
 
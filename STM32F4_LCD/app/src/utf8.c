@@ -0,0 +1,426 @@
+/**
+ * @file:   utf8.c
+ * @brief:  UTF-8 text on the LCD
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Strings are decoded from UTF-8 and every code point is
+ * translated to a code of the character ROM with a constant
+ * table (U+00A0 - U+017F) or a switch (a few symbols), so no
+ * searching is done at runtime. Characters missing from the
+ * ROM are drawn with custom glyphs (see glyphs.c), which are
+ * registered the first time they are needed. Letters that
+ * have neither are printed without the diacritic and anything
+ * else as UTF8_UNKNOWN.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <utf8.h>
+#include <glyphs.h>
+#include <hd44780.h>
+#include <stdio.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) printf("UTF8--> "str"%s",##args,"\r")
+  #define println(str, args...) printf("UTF8--> "str"%s",##args,"\r\n")
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+/**
+ * @addtogroup UTF8
+ * @{
+ */
+
+#define UTF8_UNKNOWN    '?'     ///< Printed for characters that can't be displayed
+#define UTF8_INVALID    0xfffd  ///< Code point returned for malformed sequences
+#define UTF8_MAX_WIDTH  40      ///< Maximum width of a field
+
+#define UTF8_TABLE_FIRST 0x00a0 ///< First code point in the table
+#define UTF8_TABLE_LAST  0x017f ///< Last code point in the table
+
+/*
+ * Table entries: 0 - no mapping, below UTF8_GLYPHS - fallback
+ * glyph number + 1, otherwise a ROM code (codes below 0x20
+ * are CGRAM or control characters, so they are free to use).
+ */
+#define UTF8_GLYPHS   0x20        ///< Entries below are fallback glyphs
+#define UTF8_GLYPH(n) ((n) + 1)   ///< Table entry of fallback glyph n
+#define UTF8_INDEX(c) ((c) - UTF8_TABLE_FIRST) ///< Table index of code point c
+
+/**
+ * @brief Fallback glyphs.
+ */
+enum {
+  G_a_OGONEK, G_c_ACUTE, G_e_OGONEK, G_l_STROKE, G_n_ACUTE,
+  G_o_ACUTE, G_s_ACUTE, G_z_ACUTE, G_z_DOT,
+  G_A_OGONEK, G_C_ACUTE, G_E_OGONEK, G_L_STROKE, G_N_ACUTE,
+  G_O_ACUTE, G_S_ACUTE, G_Z_ACUTE, G_Z_DOT,
+  G_BACKSLASH, G_TILDE,
+  G_COUNT
+};
+
+/**
+ * @brief Fallback glyph.
+ */
+typedef struct {
+  uint8_t bitmap[8];  ///< 5x8 pattern
+  char    base;       ///< Printed when the glyph can't be loaded
+} UTF8_Glyph_TypeDef;
+
+static const UTF8_Glyph_TypeDef utf8Glyphs[G_COUNT] = {
+  [G_a_OGONEK]  = {{0x00, 0x00, 0x0e, 0x01, 0x0f, 0x11, 0x0f, 0x02}, 'a'},
+  [G_c_ACUTE]   = {{0x02, 0x04, 0x0e, 0x10, 0x10, 0x11, 0x0e, 0x00}, 'c'},
+  [G_e_OGONEK]  = {{0x00, 0x00, 0x0e, 0x11, 0x1f, 0x10, 0x0e, 0x02}, 'e'},
+  [G_l_STROKE]  = {{0x0c, 0x04, 0x06, 0x0c, 0x04, 0x04, 0x0e, 0x00}, 'l'},
+  [G_n_ACUTE]   = {{0x02, 0x04, 0x16, 0x19, 0x11, 0x11, 0x11, 0x00}, 'n'},
+  [G_o_ACUTE]   = {{0x02, 0x04, 0x0e, 0x11, 0x11, 0x11, 0x0e, 0x00}, 'o'},
+  [G_s_ACUTE]   = {{0x02, 0x04, 0x0e, 0x10, 0x0e, 0x01, 0x1e, 0x00}, 's'},
+  [G_z_ACUTE]   = {{0x02, 0x04, 0x1f, 0x02, 0x04, 0x08, 0x1f, 0x00}, 'z'},
+  [G_z_DOT]     = {{0x04, 0x00, 0x1f, 0x02, 0x04, 0x08, 0x1f, 0x00}, 'z'},
+  [G_A_OGONEK]  = {{0x0e, 0x11, 0x11, 0x11, 0x1f, 0x11, 0x11, 0x02}, 'A'},
+  [G_C_ACUTE]   = {{0x02, 0x0f, 0x10, 0x10, 0x10, 0x10, 0x0f, 0x00}, 'C'},
+  [G_E_OGONEK]  = {{0x1f, 0x10, 0x10, 0x1e, 0x10, 0x10, 0x1f, 0x02}, 'E'},
+  [G_L_STROKE]  = {{0x10, 0x10, 0x14, 0x18, 0x10, 0x10, 0x1f, 0x00}, 'L'},
+  [G_N_ACUTE]   = {{0x02, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11, 0x00}, 'N'},
+  [G_O_ACUTE]   = {{0x02, 0x0e, 0x11, 0x11, 0x11, 0x11, 0x0e, 0x00}, 'O'},
+  [G_S_ACUTE]   = {{0x02, 0x0f, 0x10, 0x0e, 0x01, 0x01, 0x1e, 0x00}, 'S'},
+  [G_Z_ACUTE]   = {{0x02, 0x1f, 0x01, 0x02, 0x04, 0x08, 0x1f, 0x00}, 'Z'},
+  [G_Z_DOT]     = {{0x04, 0x1f, 0x01, 0x02, 0x04, 0x08, 0x1f, 0x00}, 'Z'},
+  [G_BACKSLASH] = {{0x00, 0x10, 0x08, 0x04, 0x02, 0x01, 0x00, 0x00}, UTF8_UNKNOWN},
+  [G_TILDE]     = {{0x00, 0x00, 0x08, 0x15, 0x02, 0x00, 0x00, 0x00}, UTF8_UNKNOWN},
+};
+
+/**
+ * @brief Code point to ROM code translation (U+00A0 - U+017F).
+ */
+static const uint8_t utf8Table[UTF8_TABLE_LAST - UTF8_TABLE_FIRST + 1] = {
+
+  [UTF8_INDEX(0x00a0)] = ' ',                     // no-break space
+#ifdef UTF8_ROM_A02
+  // Most of the upper half of A02 follows ISO 8859-1
+  [UTF8_INDEX(0x00a1)] = 0xa1, [UTF8_INDEX(0x00a2)] = 0xa2, [UTF8_INDEX(0x00a3)] = 0xa3,
+  [UTF8_INDEX(0x00a5)] = 0xa5, [UTF8_INDEX(0x00a7)] = 0xa7, [UTF8_INDEX(0x00a9)] = 0xa9,
+  [UTF8_INDEX(0x00ab)] = 0xab, [UTF8_INDEX(0x00b0)] = 0xb0, [UTF8_INDEX(0x00b1)] = 0xb1,
+  [UTF8_INDEX(0x00b2)] = 0xb2, [UTF8_INDEX(0x00b3)] = 0xb3, [UTF8_INDEX(0x00b5)] = 0xb5,
+  [UTF8_INDEX(0x00b6)] = 0xb6, [UTF8_INDEX(0x00b7)] = 0xb7, [UTF8_INDEX(0x00bb)] = 0xbb,
+  [UTF8_INDEX(0x00bf)] = 0xbf, [UTF8_INDEX(0x00c0)] = 0xc0, [UTF8_INDEX(0x00c1)] = 0xc1,
+  [UTF8_INDEX(0x00c2)] = 0xc2, [UTF8_INDEX(0x00c3)] = 0xc3, [UTF8_INDEX(0x00c4)] = 0xc4,
+  [UTF8_INDEX(0x00c5)] = 0xc5, [UTF8_INDEX(0x00c6)] = 0xc6, [UTF8_INDEX(0x00c7)] = 0xc7,
+  [UTF8_INDEX(0x00c8)] = 0xc8, [UTF8_INDEX(0x00c9)] = 0xc9, [UTF8_INDEX(0x00ca)] = 0xca,
+  [UTF8_INDEX(0x00cb)] = 0xcb, [UTF8_INDEX(0x00cc)] = 0xcc, [UTF8_INDEX(0x00cd)] = 0xcd,
+  [UTF8_INDEX(0x00ce)] = 0xce, [UTF8_INDEX(0x00cf)] = 0xcf, [UTF8_INDEX(0x00d0)] = 0xd0,
+  [UTF8_INDEX(0x00d1)] = 0xd1, [UTF8_INDEX(0x00d2)] = 0xd2, [UTF8_INDEX(0x00d3)] = 0xd3,
+  [UTF8_INDEX(0x00d4)] = 0xd4, [UTF8_INDEX(0x00d5)] = 0xd5, [UTF8_INDEX(0x00d6)] = 0xd6,
+  [UTF8_INDEX(0x00d7)] = 0xd7, [UTF8_INDEX(0x00d8)] = 0xd8, [UTF8_INDEX(0x00d9)] = 0xd9,
+  [UTF8_INDEX(0x00da)] = 0xda, [UTF8_INDEX(0x00db)] = 0xdb, [UTF8_INDEX(0x00dc)] = 0xdc,
+  [UTF8_INDEX(0x00dd)] = 0xdd, [UTF8_INDEX(0x00de)] = 0xde, [UTF8_INDEX(0x00df)] = 0xdf,
+  [UTF8_INDEX(0x00e0)] = 0xe0, [UTF8_INDEX(0x00e1)] = 0xe1, [UTF8_INDEX(0x00e2)] = 0xe2,
+  [UTF8_INDEX(0x00e3)] = 0xe3, [UTF8_INDEX(0x00e4)] = 0xe4, [UTF8_INDEX(0x00e5)] = 0xe5,
+  [UTF8_INDEX(0x00e6)] = 0xe6, [UTF8_INDEX(0x00e7)] = 0xe7, [UTF8_INDEX(0x00e8)] = 0xe8,
+  [UTF8_INDEX(0x00e9)] = 0xe9, [UTF8_INDEX(0x00ea)] = 0xea, [UTF8_INDEX(0x00eb)] = 0xeb,
+  [UTF8_INDEX(0x00ec)] = 0xec, [UTF8_INDEX(0x00ed)] = 0xed, [UTF8_INDEX(0x00ee)] = 0xee,
+  [UTF8_INDEX(0x00ef)] = 0xef, [UTF8_INDEX(0x00f0)] = 0xf0, [UTF8_INDEX(0x00f1)] = 0xf1,
+  [UTF8_INDEX(0x00f2)] = 0xf2, [UTF8_INDEX(0x00f3)] = 0xf3, [UTF8_INDEX(0x00f4)] = 0xf4,
+  [UTF8_INDEX(0x00f5)] = 0xf5, [UTF8_INDEX(0x00f6)] = 0xf6, [UTF8_INDEX(0x00f7)] = 0xf7,
+  [UTF8_INDEX(0x00f8)] = 0xf8, [UTF8_INDEX(0x00f9)] = 0xf9, [UTF8_INDEX(0x00fa)] = 0xfa,
+  [UTF8_INDEX(0x00fb)] = 0xfb, [UTF8_INDEX(0x00fc)] = 0xfc, [UTF8_INDEX(0x00fd)] = 0xfd,
+  [UTF8_INDEX(0x00fe)] = 0xfe, [UTF8_INDEX(0x00ff)] = 0xff,
+#else
+  [UTF8_INDEX(0x00a2)] = 0xec,                    // ¢
+  [UTF8_INDEX(0x00a3)] = 0xed,                    // £
+  [UTF8_INDEX(0x00a5)] = 0x5c,                    // ¥
+  [UTF8_INDEX(0x00b0)] = 0xdf,                    // °
+  [UTF8_INDEX(0x00b5)] = 0xe4,                    // µ
+  [UTF8_INDEX(0x00b7)] = 0xa5,                    // ·
+  [UTF8_INDEX(0x00df)] = 0xe2,                    // ß (drawn as beta)
+  [UTF8_INDEX(0x00e4)] = 0xe1,                    // ä
+  [UTF8_INDEX(0x00f1)] = 0xee,                    // ñ
+  [UTF8_INDEX(0x00f6)] = 0xef,                    // ö
+  [UTF8_INDEX(0x00f7)] = 0xfd,                    // ÷
+  [UTF8_INDEX(0x00fc)] = 0xf5,                    // ü
+  [UTF8_INDEX(0x00d3)] = UTF8_GLYPH(G_O_ACUTE),   // Ó
+  [UTF8_INDEX(0x00f3)] = UTF8_GLYPH(G_o_ACUTE),   // ó
+  // letters missing from the ROM lose the diacritic
+  [UTF8_INDEX(0x00c0) ... UTF8_INDEX(0x00c5)] = 'A',
+  [UTF8_INDEX(0x00c7)] = 'C',
+  [UTF8_INDEX(0x00c8) ... UTF8_INDEX(0x00cb)] = 'E',
+  [UTF8_INDEX(0x00cc) ... UTF8_INDEX(0x00cf)] = 'I',
+  [UTF8_INDEX(0x00d1)] = 'N',
+  [UTF8_INDEX(0x00d2)] = 'O',
+  [UTF8_INDEX(0x00d4) ... UTF8_INDEX(0x00d6)] = 'O',
+  [UTF8_INDEX(0x00d9) ... UTF8_INDEX(0x00dc)] = 'U',
+  [UTF8_INDEX(0x00dd)] = 'Y',
+  [UTF8_INDEX(0x00e0) ... UTF8_INDEX(0x00e3)] = 'a',
+  [UTF8_INDEX(0x00e5)] = 'a',
+  [UTF8_INDEX(0x00e7)] = 'c',
+  [UTF8_INDEX(0x00e8) ... UTF8_INDEX(0x00eb)] = 'e',
+  [UTF8_INDEX(0x00ec) ... UTF8_INDEX(0x00ef)] = 'i',
+  [UTF8_INDEX(0x00f2)] = 'o',
+  [UTF8_INDEX(0x00f4) ... UTF8_INDEX(0x00f5)] = 'o',
+  [UTF8_INDEX(0x00f9) ... UTF8_INDEX(0x00fb)] = 'u',
+  [UTF8_INDEX(0x00fd)] = 'y',
+  [UTF8_INDEX(0x00ff)] = 'y',
+#endif
+  // Polish letters (not in any ROM)
+  [UTF8_INDEX(0x0104)] = UTF8_GLYPH(G_A_OGONEK),  // Ą
+  [UTF8_INDEX(0x0105)] = UTF8_GLYPH(G_a_OGONEK),  // ą
+  [UTF8_INDEX(0x0106)] = UTF8_GLYPH(G_C_ACUTE),   // Ć
+  [UTF8_INDEX(0x0107)] = UTF8_GLYPH(G_c_ACUTE),   // ć
+  [UTF8_INDEX(0x0118)] = UTF8_GLYPH(G_E_OGONEK),  // Ę
+  [UTF8_INDEX(0x0119)] = UTF8_GLYPH(G_e_OGONEK),  // ę
+  [UTF8_INDEX(0x0141)] = UTF8_GLYPH(G_L_STROKE),  // Ł
+  [UTF8_INDEX(0x0142)] = UTF8_GLYPH(G_l_STROKE),  // ł
+  [UTF8_INDEX(0x0143)] = UTF8_GLYPH(G_N_ACUTE),   // Ń
+  [UTF8_INDEX(0x0144)] = UTF8_GLYPH(G_n_ACUTE),   // ń
+  [UTF8_INDEX(0x015a)] = UTF8_GLYPH(G_S_ACUTE),   // Ś
+  [UTF8_INDEX(0x015b)] = UTF8_GLYPH(G_s_ACUTE),   // ś
+  [UTF8_INDEX(0x0179)] = UTF8_GLYPH(G_Z_ACUTE),   // Ź
+  [UTF8_INDEX(0x017a)] = UTF8_GLYPH(G_z_ACUTE),   // ź
+  [UTF8_INDEX(0x017b)] = UTF8_GLYPH(G_Z_DOT),     // Ż
+  [UTF8_INDEX(0x017c)] = UTF8_GLYPH(G_z_DOT),     // ż
+};
+
+static int8_t glyphId[G_COUNT]; ///< GLYPH ID of each fallback glyph (-1 - not registered)
+
+static uint8_t UTF8_Lookup(uint32_t codePoint);
+static uint8_t UTF8_Symbol(uint32_t codePoint);
+static uint8_t UTF8_Glyph(uint8_t n);
+
+/**
+ * @brief Initialize the UTF-8 layer.
+ * @details Call after GLYPH_Init - fallback glyphs are
+ * registered again when needed.
+ */
+void UTF8_Init(void) {
+
+  uint8_t i;
+  for (i = 0; i < G_COUNT; i++) {
+    glyphId[i] = -1;
+  }
+}
+/**
+ * @brief Decodes one character.
+ * @param s Pointer to the string - advanced past the character
+ * @return Code point, 0 at the end of the string or UTF8_INVALID
+ * for a malformed sequence
+ */
+uint32_t UTF8_Decode(const char** s) {
+
+  // smallest code point of each sequence length - shorter forms are overlong
+  static const uint32_t minCodePoint[4] = {0, 0x80, 0x800, 0x10000};
+
+  const uint8_t* p = (const uint8_t*)*s;
+  uint32_t codePoint;
+  uint8_t follow;
+  uint8_t length;
+
+  if (*p == 0) {
+    return 0;
+  }
+
+  if (*p < 0x80) {
+    codePoint = *p;
+    follow = 0;
+  } else if ((*p & 0xe0) == 0xc0) {
+    codePoint = *p & 0x1f;
+    follow = 1;
+  } else if ((*p & 0xf0) == 0xe0) {
+    codePoint = *p & 0x0f;
+    follow = 2;
+  } else if ((*p & 0xf8) == 0xf0) {
+    codePoint = *p & 0x07;
+    follow = 3;
+  } else {
+    *s += 1; // stray continuation byte
+    return UTF8_INVALID;
+  }
+  p++;
+  length = follow;
+
+  while (follow--) {
+    if ((*p & 0xc0) != 0x80) { // truncated - don't swallow the next character
+      *s = (const char*)p;
+      return UTF8_INVALID;
+    }
+    codePoint = (codePoint << 6) | (*p++ & 0x3f);
+  }
+
+  *s = (const char*)p;
+
+  // overlong forms, UTF-16 surrogates and values above Unicode range
+  if (codePoint < minCodePoint[length] ||
+      (codePoint >= 0xd800 && codePoint <= 0xdfff) || codePoint > 0x10ffff) {
+    return UTF8_INVALID;
+  }
+  return codePoint;
+}
+/**
+ * @brief Translates a code point to a character code of the display.
+ * @details Fallback glyphs are loaded into CGRAM of the
+ * selected display when needed.
+ * @param codePoint Unicode code point
+ * @return Character code
+ */
+uint8_t UTF8_Map(uint32_t codePoint) {
+
+  if (codePoint < 0x20) {
+    return codePoint; // control characters are passed to LCD_Putc
+  }
+
+  if (codePoint > UTF8_TABLE_LAST) {
+    return UTF8_Symbol(codePoint);
+  }
+
+  uint8_t entry = UTF8_Lookup(codePoint);
+
+  if (entry == 0) {
+    return UTF8_UNKNOWN;
+  }
+  if (entry < UTF8_GLYPHS) {
+    return UTF8_Glyph(entry - 1);
+  }
+  return entry;
+}
+/**
+ * @brief Prints a UTF-8 string at the current position.
+ * @param s String
+ */
+void UTF8_Puts(const char* s) {
+
+  uint32_t codePoint;
+
+  while ((codePoint = UTF8_Decode(&s)) != 0) {
+    LCD_Putc(UTF8_Map(codePoint));
+  }
+}
+/**
+ * @brief Writes a UTF-8 string to a field of the display.
+ * @details The text is translated and written with LCD_Write,
+ * so only changed characters are sent. The rest of the field
+ * is filled with spaces.
+ * @param positionX Column of the field
+ * @param positionY Row
+ * @param s String
+ * @param width Width of the field in characters
+ */
+void UTF8_Write(uint8_t positionX, uint8_t positionY, const char* s,
+    uint8_t width) {
+
+  char buf[UTF8_MAX_WIDTH];
+  uint32_t codePoint;
+  uint8_t i = 0;
+
+  if (width > UTF8_MAX_WIDTH) {
+    width = UTF8_MAX_WIDTH;
+  }
+
+  while (i < width && (codePoint = UTF8_Decode(&s)) != 0) {
+    buf[i++] = UTF8_Map(codePoint);
+  }
+  while (i < width) {
+    buf[i++] = ' ';
+  }
+
+  LCD_Write(positionX, positionY, buf, width);
+}
+/**
+ * @brief Finds the table entry of a code point.
+ * @param codePoint Unicode code point (up to UTF8_TABLE_LAST)
+ * @return Table entry (see utf8Table)
+ */
+static uint8_t UTF8_Lookup(uint32_t codePoint) {
+
+  if (codePoint < 0x80) {
+#ifndef UTF8_ROM_A02
+    // A00 has yen and arrow in place of these
+    if (codePoint == '\\') {
+      return UTF8_GLYPH(G_BACKSLASH);
+    }
+    if (codePoint == '~') {
+      return UTF8_GLYPH(G_TILDE);
+    }
+#endif
+    return codePoint;
+  }
+
+  if (codePoint >= UTF8_TABLE_FIRST) {
+    return utf8Table[codePoint - UTF8_TABLE_FIRST];
+  }
+
+  return 0;
+}
+/**
+ * @brief Translates symbols above the table.
+ * @param codePoint Unicode code point
+ * @return ROM code
+ */
+static uint8_t UTF8_Symbol(uint32_t codePoint) {
+
+  switch (codePoint) {
+#ifdef UTF8_ROM_A02
+  case 0x2190: return 0x1b; // ←
+  case 0x2191: return 0x18; // ↑
+  case 0x2192: return 0x1a; // →
+  case 0x2193: return 0x19; // ↓
+  case 0x2264: return 0x1c; // ≤
+  case 0x2265: return 0x1d; // ≥
+#else
+  case 0x03b1: return 0xe0; // α
+  case 0x03b2: return 0xe2; // β
+  case 0x03b5: return 0xe3; // ε
+  case 0x03bc: return 0xe4; // μ
+  case 0x03c3: return 0xe5; // σ
+  case 0x03c1: return 0xe6; // ρ
+  case 0x03b8: return 0xf2; // θ
+  case 0x03a9: return 0xf4; // Ω
+  case 0x03a3: return 0xf6; // Σ
+  case 0x03c0: return 0xf7; // π
+  case 0x221a: return 0xe8; // √
+  case 0x221e: return 0xf3; // ∞
+  case 0x2190: return 0x7f; // ←
+  case 0x2192: return 0x7e; // →
+  case 0x2588: return 0xff; // █
+#endif
+  default:     return UTF8_UNKNOWN;
+  }
+}
+/**
+ * @brief Loads a fallback glyph.
+ * @param n Fallback glyph number
+ * @return Character code
+ */
+static uint8_t UTF8_Glyph(uint8_t n) {
+
+  if (glyphId[n] < 0) {
+    glyphId[n] = GLYPH_Add(utf8Glyphs[n].bitmap);
+  }
+
+  int8_t code = -1;
+  if (glyphId[n] >= 0) {
+    code = GLYPH_Use(glyphId[n]);
+  }
+
+  if (code < 0) {
+    return utf8Glyphs[n].base;
+  }
+  return code;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,541 @@
+/**
+ * @file:   widget.c
+ * @brief:  LCD widgets redrawn only when changed
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * A screen is built once from widgets - labels, numeric fields,
+ * bar graphs and lists with a selected item. Changing a widget
+ * only marks it dirty; WIDGET_Render (called from the main loop)
+ * draws the dirty ones through LCD_Write, which in turn sends only
+ * the characters that differ from the display contents. A screen
+ * refresh therefore costs the changed characters, not the screen.
+ *
+ * Bar graphs use custom glyphs for partially filled characters
+ * (and for the full one on the A02 ROM, which has no block).
+ * They share the 8 CGRAM slots with other glyphs, e.g. the
+ * fallbacks of utf8.c. When more glyphs are in use than there
+ * are slots, the least recently used one is replaced (see
+ * glyphs.c) - bar cells already on the display then change to
+ * the new glyph. LCD_Write compares character codes, not glyphs,
+ * so they aren't redrawn - keep the glyphs on one display within
+ * 8 or invalidate the bars after drawing other glyphs.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <widget.h>
+#include <hd44780.h>
+#include <glyphs.h>
+#include <utf8.h>
+#include <stdio.h>
+
+#ifndef DEBUG
+  #define DEBUG
+#endif
+
+#ifdef DEBUG
+  #define print(str, args...) printf("WIDGET--> "str"%s",##args,"\r")
+  #define println(str, args...) printf("WIDGET--> "str"%s",##args,"\r\n")
+#else
+  #define print(str, args...) (void)0
+  #define println(str, args...) (void)0
+#endif
+
+/**
+ * @addtogroup WIDGET
+ * @{
+ */
+
+#define MAX_WIDGETS       16    ///< Maximum number of widgets
+#define WIDGET_WIDTH      40    ///< Maximum width of a widget
+#define WIDGET_BAR_STEPS  5     ///< Bar graph steps in one character (pixel columns)
+#ifndef UTF8_ROM_A02
+#define WIDGET_BAR_FULL   0xff  ///< Full block character of the A00 ROM
+#endif
+#define WIDGET_MARK       '>'   ///< Marker of the selected list item
+
+/**
+ * @brief Widget types.
+ */
+typedef enum {
+  WIDGET_FREE,    //!< WIDGET_FREE Widget not used
+  WIDGET_LABEL,   //!< WIDGET_LABEL Text
+  WIDGET_NUMBER,  //!< WIDGET_NUMBER Right aligned fixed point number
+  WIDGET_BAR,     //!< WIDGET_BAR Horizontal bar graph
+  WIDGET_LIST,    //!< WIDGET_LIST List of items, one of them selected
+} WIDGET_Type_TypeDef;
+
+/**
+ * @brief Widget structure.
+ */
+typedef struct {
+  uint8_t type;             ///< Widget type (WIDGET_Type_TypeDef)
+  uint8_t display;          ///< Display showing the widget
+  uint8_t x;                ///< Column
+  uint8_t y;                ///< Row
+  uint8_t width;            ///< Width in characters
+  uint8_t rows;             ///< Height in rows (lists only)
+  uint8_t dirty;            ///< Has to be redrawn
+  uint8_t decimals;         ///< Digits after the decimal point (numbers)
+  uint8_t count;            ///< Number of items (lists)
+  uint8_t top;              ///< First visible item (lists)
+  int32_t value;            ///< Number, bar value or selected item
+  int32_t max;              ///< Value of a full bar
+  const char* text;         ///< Label text
+  const char* const* items; ///< List items
+} WIDGET_TypeDef;
+
+/**
+ * @brief Bar characters with 1 to 5 columns filled (the last
+ * one, a full block, is used only on the A02 ROM).
+ */
+static const uint8_t barBitmaps[WIDGET_BAR_STEPS][8] = {
+  {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x00},
+  {0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x00},
+  {0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x1c, 0x00},
+  {0x1e, 0x1e, 0x1e, 0x1e, 0x1e, 0x1e, 0x1e, 0x00},
+  {0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f},
+};
+
+#ifdef UTF8_ROM_A02
+#define WIDGET_BAR_GLYPHS WIDGET_BAR_STEPS        ///< Full block is a glyph too
+#else
+#define WIDGET_BAR_GLYPHS (WIDGET_BAR_STEPS - 1)  ///< Full block is in the ROM
+#endif
+
+static WIDGET_TypeDef widgets[MAX_WIDGETS];         ///< Array of widgets
+static int8_t barGlyphs[WIDGET_BAR_GLYPHS];         ///< Glyph IDs of bar characters
+
+static int8_t WIDGET_Add(uint8_t type, uint8_t positionX, uint8_t positionY,
+    uint8_t width, uint8_t rows);
+static WIDGET_TypeDef* WIDGET_Get(uint8_t id);
+static void WIDGET_Draw(WIDGET_TypeDef* w);
+static void WIDGET_DrawBar(WIDGET_TypeDef* w);
+static void WIDGET_DrawList(WIDGET_TypeDef* w);
+static char WIDGET_BarChar(uint8_t columns);
+
+/**
+ * @brief Initialize the widgets.
+ * @details Call after GLYPH_Init - registers bar graph glyphs
+ * (they share CGRAM with other glyphs, see above).
+ */
+void WIDGET_Init(void) {
+
+  uint8_t i;
+  for (i = 0; i < MAX_WIDGETS; i++) {
+    widgets[i].type = WIDGET_FREE;
+  }
+  for (i = 0; i < WIDGET_BAR_GLYPHS; i++) {
+    barGlyphs[i] = GLYPH_Add(barBitmaps[i]);
+  }
+}
+/**
+ * @brief Adds a label on the selected display.
+ * @details Text is clipped or padded with spaces to the width.
+ * @param positionX Column
+ * @param positionY Row
+ * @param width Width
+ * @param text Text (has to stay valid while it is shown)
+ * @return Widget ID or error code (-1)
+ * @retval -1 Error: too many widgets or wrong width
+ */
+int8_t WIDGET_AddLabel(uint8_t positionX, uint8_t positionY, uint8_t width,
+    const char* text) {
+
+  int8_t id = WIDGET_Add(WIDGET_LABEL, positionX, positionY, width, 1);
+
+  if (id >= 0) {
+    widgets[id].text = text;
+  }
+  return id;
+}
+/**
+ * @brief Adds a numeric field on the selected display.
+ * @details The number is right aligned, '*' is shown if it
+ * doesn't fit (see LCD_PutFixed). Starts with 0.
+ * @param positionX Column
+ * @param positionY Row
+ * @param width Width
+ * @param decimals Number of digits after the decimal point
+ * @return Widget ID or error code (-1)
+ * @retval -1 Error: too many widgets or wrong width
+ */
+int8_t WIDGET_AddNumber(uint8_t positionX, uint8_t positionY, uint8_t width,
+    uint8_t decimals) {
+
+  int8_t id = WIDGET_Add(WIDGET_NUMBER, positionX, positionY, width, 1);
+
+  if (id >= 0) {
+    widgets[id].decimals = decimals;
+  }
+  return id;
+}
+/**
+ * @brief Adds a horizontal bar graph on the selected display.
+ * @details Resolution is 5 steps per character. Starts empty.
+ * @param positionX Column
+ * @param positionY Row
+ * @param width Width
+ * @param max Value of a full bar
+ * @return Widget ID or error code (-1)
+ * @retval -1 Error: too many widgets, wrong width or maximum
+ */
+int8_t WIDGET_AddBar(uint8_t positionX, uint8_t positionY, uint8_t width,
+    int32_t max) {
+
+  if (max <= 0) {
+    println("Wrong maximum!");
+    return -1;
+  }
+
+  int8_t id = WIDGET_Add(WIDGET_BAR, positionX, positionY, width, 1);
+
+  if (id >= 0) {
+    widgets[id].max = max;
+  }
+  return id;
+}
+/**
+ * @brief Adds a list on the selected display.
+ * @details Shows rows items starting at positionY, the selected
+ * one (value of the widget) marked with '>'. The list scrolls to
+ * keep the selected item visible. Starts with the first item.
+ * @param positionX Column
+ * @param positionY First row
+ * @param width Width (with the marker)
+ * @param rows Number of visible rows
+ * @param items Items (have to stay valid while shown)
+ * @param count Number of items
+ * @return Widget ID or error code (-1)
+ * @retval -1 Error: too many widgets, wrong size or no items
+ */
+int8_t WIDGET_AddList(uint8_t positionX, uint8_t positionY, uint8_t width,
+    uint8_t rows, const char* const* items, uint8_t count) {
+
+  if (count == 0) {
+    println("Empty list!");
+    return -1;
+  }
+
+  int8_t id = WIDGET_Add(WIDGET_LIST, positionX, positionY, width, rows);
+
+  if (id >= 0) {
+    widgets[id].items = items;
+    widgets[id].count = count;
+  }
+  return id;
+}
+/**
+ * @brief Frees a widget (its contents stay on display).
+ * @param id Widget ID
+ */
+void WIDGET_Remove(uint8_t id) {
+
+  WIDGET_TypeDef* w = WIDGET_Get(id);
+
+  if (w) {
+    w->type = WIDGET_FREE;
+  }
+}
+/**
+ * @brief Changes text of a label.
+ * @param id Widget ID
+ * @param text New text (has to stay valid while it is shown)
+ */
+void WIDGET_SetText(uint8_t id, const char* text) {
+
+  WIDGET_TypeDef* w = WIDGET_Get(id);
+
+  if (!w || w->type != WIDGET_LABEL) {
+    println("Not a label!");
+    return;
+  }
+
+  w->text = text;
+  w->dirty = 1;
+}
+/**
+ * @brief Changes value of a number, bar or list.
+ * @details Values of a list are item indexes, out of range
+ * ones are limited. The widget is redrawn only if the value
+ * has changed.
+ * @param id Widget ID
+ * @param value New value
+ */
+void WIDGET_SetValue(uint8_t id, int32_t value) {
+
+  WIDGET_TypeDef* w = WIDGET_Get(id);
+
+  if (!w || w->type == WIDGET_LABEL) {
+    println("Widget has no value!");
+    return;
+  }
+
+  if (w->type == WIDGET_LIST) {
+    if (value < 0) {
+      value = 0;
+    } else if (value >= w->count) {
+      value = w->count - 1;
+    }
+  }
+
+  if (w->value != value) {
+    w->value = value;
+    w->dirty = 1;
+  }
+}
+/**
+ * @brief Returns value of a number, bar or list.
+ * @param id Widget ID
+ * @return Value (0 for wrong ID)
+ */
+int32_t WIDGET_GetValue(uint8_t id) {
+
+  WIDGET_TypeDef* w = WIDGET_Get(id);
+
+  return w ? w->value : 0;
+}
+/**
+ * @brief Forces a redraw of a widget.
+ * @details Needed when a label text is changed in place or
+ * the display was cleared.
+ * @param id Widget ID
+ */
+void WIDGET_Invalidate(uint8_t id) {
+
+  WIDGET_TypeDef* w = WIDGET_Get(id);
+
+  if (w) {
+    w->dirty = 1;
+  }
+}
+/**
+ * @brief Draws all changed widgets.
+ * @details Call from the main loop, e.g. before LCD_Update.
+ */
+void WIDGET_Render(void) {
+
+  LCD_Display_TypeDef selected = LCD_GetSelected();
+
+  uint8_t i;
+  for (i = 0; i < MAX_WIDGETS; i++) {
+
+    WIDGET_TypeDef* w = &widgets[i];
+
+    if (w->type == WIDGET_FREE || !w->dirty) {
+      continue;
+    }
+    w->dirty = 0;
+
+    LCD_Select(w->display);
+    WIDGET_Draw(w);
+  }
+
+  LCD_Select(selected);
+}
+/**
+ * @brief Finds a free widget and sets its common fields.
+ * @param type Widget type
+ * @param positionX Column
+ * @param positionY Row
+ * @param width Width
+ * @param rows Height
+ * @return Widget ID or error code (-1)
+ */
+static int8_t WIDGET_Add(uint8_t type, uint8_t positionX, uint8_t positionY,
+    uint8_t width, uint8_t rows) {
+
+  if (width == 0 || width > WIDGET_WIDTH || rows == 0) {
+    println("Wrong size!");
+    return -1;
+  }
+
+  uint8_t i;
+  for (i = 0; i < MAX_WIDGETS; i++) {
+
+    if (widgets[i].type == WIDGET_FREE) {
+
+      widgets[i].type     = type;
+      widgets[i].display  = LCD_GetSelected();
+      widgets[i].x        = positionX;
+      widgets[i].y        = positionY;
+      widgets[i].width    = width;
+      widgets[i].rows     = rows;
+      widgets[i].value    = 0;
+      widgets[i].top      = 0;
+      widgets[i].dirty    = 1;
+
+      return i;
+    }
+  }
+
+  println("Reached maximum number of widgets!");
+  return -1;
+}
+/**
+ * @brief Returns a used widget.
+ * @param id Widget ID
+ * @return Widget or NULL for wrong ID
+ */
+static WIDGET_TypeDef* WIDGET_Get(uint8_t id) {
+
+  if (id >= MAX_WIDGETS || widgets[id].type == WIDGET_FREE) {
+    println("Wrong widget ID %d!", (int)id);
+    return NULL;
+  }
+  return &widgets[id];
+}
+/**
+ * @brief Draws a widget on the selected display.
+ * @param w Widget
+ */
+static void WIDGET_Draw(WIDGET_TypeDef* w) {
+
+  char buf[WIDGET_WIDTH];
+
+  switch (w->type) {
+  case WIDGET_LABEL:
+    WIDGET_FormatRow(buf, w->width, WIDGET_ROW_TEXT, w->text);
+    LCD_Write(w->x, w->y, buf, w->width);
+    break;
+  case WIDGET_NUMBER:
+    LCD_PutFixed(w->x, w->y, w->width, w->value, w->decimals);
+    break;
+  case WIDGET_BAR:
+    WIDGET_DrawBar(w);
+    break;
+  case WIDGET_LIST:
+    WIDGET_DrawList(w);
+    break;
+  }
+}
+/**
+ * @brief Draws a bar graph.
+ * @param w Widget
+ */
+static void WIDGET_DrawBar(WIDGET_TypeDef* w) {
+
+  char buf[WIDGET_WIDTH];
+  int32_t value = w->value;
+
+  if (value < 0) {
+    value = 0;
+  } else if (value > w->max) {
+    value = w->max;
+  }
+
+  // number of lit pixel columns
+  uint16_t steps = (int64_t)value * w->width * WIDGET_BAR_STEPS / w->max;
+  uint8_t full = steps / WIDGET_BAR_STEPS;
+  uint8_t part = steps % WIDGET_BAR_STEPS;
+
+  uint8_t i;
+  for (i = 0; i < w->width; i++) {
+    if (i < full) {
+      buf[i] = WIDGET_BarChar(WIDGET_BAR_STEPS);
+    } else if (i == full && part) {
+      buf[i] = WIDGET_BarChar(part);
+    } else {
+      buf[i] = ' ';
+    }
+  }
+
+  LCD_Write(w->x, w->y, buf, w->width);
+}
+/**
+ * @brief Returns the code of a bar character.
+ * @param columns Number of filled pixel columns (1 to 5)
+ * @return Character code (space if the glyph is missing)
+ */
+static char WIDGET_BarChar(uint8_t columns) {
+
+#ifdef WIDGET_BAR_FULL
+  if (columns == WIDGET_BAR_STEPS) {
+    return WIDGET_BAR_FULL;
+  }
+#endif
+
+  int8_t id = barGlyphs[columns - 1];
+  int8_t code = id < 0 ? -1 : GLYPH_Use(id);
+
+  return code < 0 ? ' ' : code; // no glyph - round down
+}
+/**
+ * @brief Draws the visible part of a list.
+ * @param w Widget
+ */
+static void WIDGET_DrawList(WIDGET_TypeDef* w) {
+
+  char buf[WIDGET_WIDTH];
+
+  w->top = WIDGET_ListTop(w->top, w->value, w->rows);
+
+  uint8_t row;
+  for (row = 0; row < w->rows; row++) {
+
+    uint8_t item = w->top + row;
+
+    if (item < w->count) {
+      WIDGET_FormatRow(buf, w->width, item == w->value ?
+          WIDGET_ROW_SELECTED : WIDGET_ROW_ITEM, w->items[item]);
+    } else {
+      WIDGET_FormatRow(buf, w->width, WIDGET_ROW_TEXT, NULL);
+    }
+
+    LCD_Write(w->x, w->y + row, buf, w->width);
+  }
+}
+/**
+ * @brief Scrolls a list window to keep the selected item visible.
+ * @param top First visible item
+ * @param selected Selected item
+ * @param rows Number of visible rows
+ * @return New first visible item
+ */
+uint8_t WIDGET_ListTop(uint8_t top, uint8_t selected, uint8_t rows) {
+
+  if (selected < top) {
+    return selected;
+  }
+  if (selected >= top + rows) {
+    return selected - rows + 1;
+  }
+  return top;
+}
+/**
+ * @brief Formats a row of a label or a list.
+ * @details List items start with a marker column. Text is
+ * clipped or padded with spaces to the width.
+ * @param buf Buffer for width characters (not terminated)
+ * @param width Width
+ * @param kind Kind of the row
+ * @param text Text (NULL - empty row)
+ */
+void WIDGET_FormatRow(char* buf, uint8_t width, WIDGET_Row_TypeDef kind,
+    const char* text) {
+
+  uint8_t i = 0;
+
+  if (kind != WIDGET_ROW_TEXT && width) {
+    buf[i++] = (kind == WIDGET_ROW_SELECTED) ? WIDGET_MARK : ' ';
+  }
+  while (text && *text && i < width) {
+    buf[i++] = *text++;
+  }
+  while (i < width) {
+    buf[i++] = ' ';
+  }
+}
+
+/**
+ * @}
+ */
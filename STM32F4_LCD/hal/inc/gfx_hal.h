@@ -0,0 +1,44 @@
+/**
+ * @file:   gfx_hal.h
+ * @brief:  DMA2D and LTDC layer for the framebuffer graphics
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef GFX_HAL_H_
+#define GFX_HAL_H_
+
+#include <inttypes.h>
+
+/*
+ * Uncomment to render in software even on parts with
+ * the DMA2D (e.g. to compare both renderers).
+ */
+//#define GFX_SOFTWARE
+
+#if defined(STM32F429_439xx) && !defined(GFX_SOFTWARE)
+  #define GFX_DMA2D ///< Rendering done by DMA2D, framebuffer shown by LTDC
+#endif
+
+#ifdef GFX_DMA2D
+void    GFX_HAL_Init    (uint16_t* buffer, uint16_t width, uint16_t height);
+void    GFX_HAL_Fill    (uint16_t* dst, uint16_t dstSkip, uint16_t w, uint16_t h,
+    uint16_t color);
+void    GFX_HAL_Copy    (uint16_t* dst, uint16_t dstSkip, const uint16_t* src,
+    uint16_t srcSkip, uint16_t w, uint16_t h);
+void    GFX_HAL_Blend   (uint16_t* dst, uint16_t dstSkip, const uint16_t* src,
+    uint16_t srcSkip, uint16_t w, uint16_t h, uint8_t alpha);
+uint8_t GFX_HAL_IsBusy  (void);
+#endif
+
+#endif /* GFX_HAL_H_ */
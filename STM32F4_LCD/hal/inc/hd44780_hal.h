@@ -20,17 +20,65 @@
 
 #include <inttypes.h>
 
+/*
+ * Uncomment if the RW line of the LCD is tied to ground.
+ * The busy flag is never read then and the driver times
+ * every instruction with the microsecond timer instead.
+ */
+//#define LCD_WRITE_ONLY
+
+/*
+ * Uncomment to use the 8-bit interface (D0..D7 on one port,
+ * see hd44780_hal.c). Every byte is then written with one
+ * store and one E strobe instead of two.
+ */
+//#define LCD_8BIT
+
+/*
+ * Number of displays sharing the data bus, RS and RW.
+ * Each one has its own E line (see hd44780_hal.c) or
+ * its own PCF8574 (see hd44780_hal_i2c.c).
+ */
+#ifndef LCD_DISPLAYS
+  #define LCD_DISPLAYS 1
+#endif
+
+#if LCD_DISPLAYS < 1 || LCD_DISPLAYS > 4
+  #error "1 to 4 displays are supported!"
+#endif
+
+/*
+ * Uncomment if the display is connected through a PCF8574
+ * I2C backpack (see hd44780_hal_i2c.c). The backpack wires
+ * only the 4-bit interface and the busy flag isn't read.
+ */
+//#define LCD_I2C
+
+#ifdef LCD_I2C
+  #ifdef LCD_8BIT
+    #error "PCF8574 backpack supports only the 4-bit interface!"
+  #endif
+  #ifndef LCD_WRITE_ONLY
+    #define LCD_WRITE_ONLY
+  #endif
+  #define LCD_HAL_QUEUE_LEN 32 ///< Transfers buffered by the transport
+#else
+  #define LCD_HAL_QUEUE_LEN 1  ///< Transfers are sent at once
+#endif
+
+void    LCD_HAL_Init        (void);
+void    LCD_HAL_Select      (uint8_t display);
+void    LCD_HAL_WriteNibble (uint8_t nibble, uint8_t rs);
+void    LCD_HAL_Send        (uint8_t data, uint8_t rs);
+
+#ifndef LCD_WRITE_ONLY
+uint8_t LCD_HAL_ReadStatus  (void);
+#else
+uint8_t LCD_HAL_Queued      (void);
+#endif
 
-void    LCD_HAL_Write   (uint8_t data);
-uint8_t LCD_HAL_Read    (void);
-void    LCD_HAL_DataOut (void);
-void    LCD_HAL_DataIn  (void);
-void    LCD_HAL_Init    (void);
-void    LCD_HAL_LowRS   (void);
-void    LCD_HAL_HighRS  (void);
-void    LCD_HAL_LowRW   (void);
-void    LCD_HAL_HighRW  (void);
-void    LCD_HAL_HighE   (void);
-void    LCD_HAL_LowE    (void);
+#ifdef LCD_I2C
+void    LCD_HAL_Update      (void);
+#endif
 
 #endif /* HD44780_HAL_H_ */
@@ -20,8 +20,41 @@
 
 #include <inttypes.h>
 
-int8_t KEYS_HAL_ReadRow(void);
+/*
+ * Uncomment to stop scanning while no key is pressed. All
+ * columns are then driven low and a press on any row line
+ * raises an EXTI interrupt, which restarts the scanning.
+ */
+//#define KEYS_USE_EXTI
+
+/*
+ * Uncomment to scan the keyboard by DMA. A timer triggers one
+ * DMA stream writing column patterns to the port and another
+ * one sampling the rows, the CPU only reads the last samples
+ * of all columns (KEYS_HAL_ReadMatrix).
+ */
+//#define KEYS_USE_DMA
+
+#if defined(KEYS_USE_EXTI) && defined(KEYS_USE_DMA)
+  #error "Keyboard can't be scanned by DMA and wait for EXTI at once!"
+#endif
+
+#define KEYS_ROWS     4 ///< Number of keyboard rows
+#define KEYS_COLUMNS  4 ///< Number of keyboard columns
+
+uint8_t KEYS_HAL_ReadRows(void);
 void KEYS_HAL_SelectColumn(uint8_t col);
 void KEYS_HAL_Init(void);
+void KEYS_HAL_StartTimer(uint32_t period, void (*tickCb)(void));
+void KEYS_HAL_StopTimer(void);
+void KEYS_HAL_Lock(void);
+void KEYS_HAL_Unlock(void);
+
+#ifdef KEYS_USE_EXTI
+void KEYS_HAL_Idle(void (*pressCb)(void));
+#endif
+#ifdef KEYS_USE_DMA
+uint16_t KEYS_HAL_ReadMatrix(void);
+#endif
 
 #endif /* KEYS_HAL_H_ */
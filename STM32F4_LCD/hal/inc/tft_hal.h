@@ -0,0 +1,37 @@
+/**
+ * @file:   tft_hal.h
+ * @brief:  SPI TFT hardware layer
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef TFT_HAL_H_
+#define TFT_HAL_H_
+
+#include <inttypes.h>
+
+/*
+ * Comment out to leave out the SPI TFT driver and free SPI2,
+ * DMA1 Streams 3 and 4 and PB10, PB12-PB15 (needed by the 8-bit
+ * HD44780 bus).
+ */
+#define TFT_ENABLE
+
+void    TFT_HAL_Init    (void (*doneCb)(void));
+void    TFT_HAL_Command (uint8_t command, const uint8_t* args, uint8_t len);
+void    TFT_HAL_Pixels  (const uint8_t* commands, uint8_t len,
+    const uint16_t* pixels, uint32_t count, uint8_t repeat);
+void    TFT_HAL_Lock    (void);
+void    TFT_HAL_Unlock  (void);
+
+#endif /* TFT_HAL_H_ */
@@ -1,5 +1,5 @@
 /**
- * @file: 	timer14.h
+ * @file: 	timer5.h
  * @brief:	   
  * @date: 	10 paź 2014
  * @author: Michal Ksiezopolski
@@ -15,10 +15,12 @@
  * @endverbatim
  */
 
-#ifndef TIMER14_H_
-#define TIMER14_H_
+#ifndef TIMER5_H_
+#define TIMER5_H_
 
-void TIMER14_Init(void);
-uint32_t TIMER14_GetTime(void);
+#include <inttypes.h>
 
-#endif /* TIMER14_H_ */
+void TIMER5_Init(void);
+uint32_t TIMER5_GetTime(void);
+
+#endif /* TIMER5_H_ */
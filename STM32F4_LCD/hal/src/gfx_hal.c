@@ -0,0 +1,266 @@
+/**
+ * @file:   gfx_hal.c
+ * @brief:  DMA2D and LTDC layer for the framebuffer graphics
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Used on STM32F429/439 only (see GFX_DMA2D in gfx_hal.h).
+ * LTDC shows the framebuffer on layer 1 of a parallel RGB
+ * panel - pins and timings are those of the 240x320 panel of
+ * the STM32F429I-DISCO board (the panel itself has to be put
+ * in RGB mode beforehand). DMA2D does the rectangle fills,
+ * copies and blends. An operation is started and the function
+ * returns, the next one waits until the previous one is done.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <gfx_hal.h>
+
+#ifdef GFX_DMA2D
+
+#include <stm32f4xx.h>
+
+/*
+ * Panel timings in pixel clocks and lines
+ */
+#define GFX_HSYNC       10  ///< Horizontal sync width
+#define GFX_HBP         20  ///< Horizontal back porch
+#define GFX_HFP         10  ///< Horizontal front porch
+#define GFX_VSYNC       2   ///< Vertical sync height
+#define GFX_VBP         2   ///< Vertical back porch
+#define GFX_VFP         4   ///< Vertical front porch
+
+/*
+ * Pixel clock: 1MHz * PLLSAIN / PLLSAIR / DIVR = 6MHz
+ */
+#define GFX_PLLSAI_N    192                   ///< PLLSAI multiplier
+#define GFX_PLLSAI_Q    7                     ///< PLLSAI divider for SAI (unused)
+#define GFX_PLLSAI_R    4                     ///< PLLSAI divider for LTDC
+#define GFX_PLLSAI_DIVR RCC_PLLSAIDivR_Div8   ///< LTDC clock divider
+
+#define GFX_AF9_LTDC    ((uint8_t)0x09)       ///< LTDC on some pins of ports B and G
+
+/**
+ * @brief LTDC pin.
+ */
+typedef struct {
+  GPIO_TypeDef* port; ///< Port
+  uint8_t source;     ///< Pin number
+  uint8_t af;         ///< Alternate function
+} GFX_HAL_Pin_TypeDef;
+
+/**
+ * @brief LTDC pins (R2..R7, G2..G7, B2..B7, HSYNC, VSYNC, DE, CLK).
+ */
+static const GFX_HAL_Pin_TypeDef ltdcPins[] = {
+  {GPIOC, 10, GPIO_AF_LTDC}, {GPIOB,  0, GFX_AF9_LTDC}, {GPIOA, 11, GPIO_AF_LTDC},
+  {GPIOA, 12, GPIO_AF_LTDC}, {GPIOB,  1, GFX_AF9_LTDC}, {GPIOG,  6, GPIO_AF_LTDC},
+  {GPIOA,  6, GPIO_AF_LTDC}, {GPIOG, 10, GFX_AF9_LTDC}, {GPIOB, 10, GPIO_AF_LTDC},
+  {GPIOB, 11, GPIO_AF_LTDC}, {GPIOC,  7, GPIO_AF_LTDC}, {GPIOD,  3, GPIO_AF_LTDC},
+  {GPIOD,  6, GPIO_AF_LTDC}, {GPIOG, 11, GPIO_AF_LTDC}, {GPIOG, 12, GFX_AF9_LTDC},
+  {GPIOA,  3, GPIO_AF_LTDC}, {GPIOB,  8, GPIO_AF_LTDC}, {GPIOB,  9, GPIO_AF_LTDC},
+  {GPIOC,  6, GPIO_AF_LTDC}, {GPIOA,  4, GPIO_AF_LTDC}, {GPIOF, 10, GPIO_AF_LTDC},
+  {GPIOG,  7, GPIO_AF_LTDC},
+};
+
+#define GFX_PINS (sizeof(ltdcPins)/sizeof(ltdcPins[0])) ///< Number of LTDC pins
+
+static void GFX_HAL_Output(uint32_t mode, uint16_t* dst, uint16_t dstSkip,
+    uint16_t w, uint16_t h, uint16_t color);
+
+/**
+ * @brief Initialize LTDC to show the framebuffer and enable DMA2D.
+ * @param buffer Framebuffer (RGB565, width*height pixels)
+ * @param width Width of the panel
+ * @param height Height of the panel
+ */
+void GFX_HAL_Init(uint16_t* buffer, uint16_t width, uint16_t height) {
+
+  GPIO_InitTypeDef        GPIO_InitStructure;
+  LTDC_InitTypeDef        LTDC_InitStructure;
+  LTDC_Layer_InitTypeDef  LTDC_Layer_InitStructure;
+
+  // Enable clocks for peripherals
+  RCC_AHB1PeriphClockCmd(RCC_AHB1Periph_GPIOA | RCC_AHB1Periph_GPIOB |
+      RCC_AHB1Periph_GPIOC | RCC_AHB1Periph_GPIOD | RCC_AHB1Periph_GPIOF |
+      RCC_AHB1Periph_GPIOG | RCC_AHB1Periph_DMA2D, ENABLE);
+  RCC_APB2PeriphClockCmd(RCC_APB2Periph_LTDC, ENABLE);
+
+  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_AF;
+  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+  GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
+  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_NOPULL;
+
+  uint8_t i;
+  for (i = 0; i < GFX_PINS; i++) {
+    GPIO_InitStructure.GPIO_Pin = 1 << ltdcPins[i].source;
+    GPIO_Init(ltdcPins[i].port, &GPIO_InitStructure);
+    GPIO_PinAFConfig(ltdcPins[i].port, ltdcPins[i].source, ltdcPins[i].af);
+  }
+
+  // Pixel clock
+  RCC_PLLSAIConfig(GFX_PLLSAI_N, GFX_PLLSAI_Q, GFX_PLLSAI_R);
+  RCC_LTDCCLKDivConfig(GFX_PLLSAI_DIVR);
+  RCC_PLLSAICmd(ENABLE);
+  while (RCC_GetFlagStatus(RCC_FLAG_PLLSAIRDY) == RESET);
+
+  // Timings - LTDC takes accumulated values minus one
+  LTDC_InitStructure.LTDC_HSPolarity          = LTDC_HSPolarity_AL;
+  LTDC_InitStructure.LTDC_VSPolarity          = LTDC_VSPolarity_AL;
+  LTDC_InitStructure.LTDC_DEPolarity          = LTDC_DEPolarity_AL;
+  LTDC_InitStructure.LTDC_PCPolarity          = LTDC_PCPolarity_IPC;
+  LTDC_InitStructure.LTDC_HorizontalSync      = GFX_HSYNC - 1;
+  LTDC_InitStructure.LTDC_VerticalSync        = GFX_VSYNC - 1;
+  LTDC_InitStructure.LTDC_AccumulatedHBP      = GFX_HSYNC + GFX_HBP - 1;
+  LTDC_InitStructure.LTDC_AccumulatedVBP      = GFX_VSYNC + GFX_VBP - 1;
+  LTDC_InitStructure.LTDC_AccumulatedActiveW  = GFX_HSYNC + GFX_HBP + width - 1;
+  LTDC_InitStructure.LTDC_AccumulatedActiveH  = GFX_VSYNC + GFX_VBP + height - 1;
+  LTDC_InitStructure.LTDC_TotalWidth          = GFX_HSYNC + GFX_HBP + width + GFX_HFP - 1;
+  LTDC_InitStructure.LTDC_TotalHeigh          = GFX_VSYNC + GFX_VBP + height + GFX_VFP - 1;
+  LTDC_InitStructure.LTDC_BackgroundRedValue    = 0;
+  LTDC_InitStructure.LTDC_BackgroundGreenValue  = 0;
+  LTDC_InitStructure.LTDC_BackgroundBlueValue   = 0;
+  LTDC_Init(&LTDC_InitStructure);
+
+  // Layer 1 covers the whole panel
+  LTDC_LayerStructInit(&LTDC_Layer_InitStructure);
+  LTDC_Layer_InitStructure.LTDC_HorizontalStart   = GFX_HSYNC + GFX_HBP;
+  LTDC_Layer_InitStructure.LTDC_HorizontalStop    = GFX_HSYNC + GFX_HBP + width - 1;
+  LTDC_Layer_InitStructure.LTDC_VerticalStart     = GFX_VSYNC + GFX_VBP;
+  LTDC_Layer_InitStructure.LTDC_VerticalStop      = GFX_VSYNC + GFX_VBP + height - 1;
+  LTDC_Layer_InitStructure.LTDC_PixelFormat       = LTDC_Pixelformat_RGB565;
+  LTDC_Layer_InitStructure.LTDC_ConstantAlpha     = 255;
+  LTDC_Layer_InitStructure.LTDC_BlendingFactor_1  = LTDC_BlendingFactor1_CA;
+  LTDC_Layer_InitStructure.LTDC_BlendingFactor_2  = LTDC_BlendingFactor2_CA;
+  LTDC_Layer_InitStructure.LTDC_CFBStartAdress    = (uint32_t)buffer;
+  LTDC_Layer_InitStructure.LTDC_CFBLineLength     = width * 2 + 3; // bytes + 3
+  LTDC_Layer_InitStructure.LTDC_CFBPitch          = width * 2;
+  LTDC_Layer_InitStructure.LTDC_CFBLineNumber     = height;
+  LTDC_LayerInit(LTDC_Layer1, &LTDC_Layer_InitStructure);
+
+  LTDC_LayerCmd(LTDC_Layer1, ENABLE);
+  LTDC_ReloadConfig(LTDC_IMReload);
+  LTDC_Cmd(ENABLE);
+}
+/**
+ * @brief Checks if DMA2D is still working.
+ * @retval 1 Transfer in progress
+ * @retval 0 DMA2D is idle
+ */
+uint8_t GFX_HAL_IsBusy(void) {
+  return (DMA2D->CR & DMA2D_CR_START) != 0;
+}
+/**
+ * @brief Fills a rectangle with a color.
+ * @param dst First pixel of the rectangle
+ * @param dstSkip Pixels between the end of a line and start of the next one
+ * @param w Width
+ * @param h Height
+ * @param color Color (RGB565)
+ */
+void GFX_HAL_Fill(uint16_t* dst, uint16_t dstSkip, uint16_t w, uint16_t h,
+    uint16_t color) {
+
+  GFX_HAL_Output(DMA2D_R2M, dst, dstSkip, w, h, color);
+  DMA2D_StartTransfer();
+}
+/**
+ * @brief Copies a rectangle.
+ * @param dst First pixel of the destination
+ * @param dstSkip Pixels skipped after each destination line
+ * @param src First pixel of the source - has to stay valid until done
+ * @param srcSkip Pixels skipped after each source line
+ * @param w Width
+ * @param h Height
+ */
+void GFX_HAL_Copy(uint16_t* dst, uint16_t dstSkip, const uint16_t* src,
+    uint16_t srcSkip, uint16_t w, uint16_t h) {
+
+  DMA2D_FG_InitTypeDef DMA2D_FG_InitStructure;
+
+  GFX_HAL_Output(DMA2D_M2M, dst, dstSkip, w, h, 0);
+
+  DMA2D_FG_StructInit(&DMA2D_FG_InitStructure);
+  DMA2D_FG_InitStructure.DMA2D_FGMA = (uint32_t)src;
+  DMA2D_FG_InitStructure.DMA2D_FGO  = srcSkip;
+  DMA2D_FG_InitStructure.DMA2D_FGCM = CM_RGB565;
+  DMA2D_FGConfig(&DMA2D_FG_InitStructure);
+
+  DMA2D_StartTransfer();
+}
+/**
+ * @brief Blends a rectangle over the framebuffer.
+ * @details dst = src * alpha + dst * (255 - alpha)
+ * @param dst First pixel of the destination
+ * @param dstSkip Pixels skipped after each destination line
+ * @param src First pixel of the source - has to stay valid until done
+ * @param srcSkip Pixels skipped after each source line
+ * @param w Width
+ * @param h Height
+ * @param alpha Opacity of the source (0..255)
+ */
+void GFX_HAL_Blend(uint16_t* dst, uint16_t dstSkip, const uint16_t* src,
+    uint16_t srcSkip, uint16_t w, uint16_t h, uint8_t alpha) {
+
+  DMA2D_FG_InitTypeDef DMA2D_FG_InitStructure;
+  DMA2D_BG_InitTypeDef DMA2D_BG_InitStructure;
+
+  GFX_HAL_Output(DMA2D_M2M_BLEND, dst, dstSkip, w, h, 0);
+
+  DMA2D_FG_StructInit(&DMA2D_FG_InitStructure);
+  DMA2D_FG_InitStructure.DMA2D_FGMA               = (uint32_t)src;
+  DMA2D_FG_InitStructure.DMA2D_FGO                = srcSkip;
+  DMA2D_FG_InitStructure.DMA2D_FGCM               = CM_RGB565;
+  DMA2D_FG_InitStructure.DMA2D_FGPFC_ALPHA_MODE   = REPLACE_ALPHA_VALUE;
+  DMA2D_FG_InitStructure.DMA2D_FGPFC_ALPHA_VALUE  = alpha;
+  DMA2D_FGConfig(&DMA2D_FG_InitStructure);
+
+  // background is the framebuffer itself
+  DMA2D_BG_StructInit(&DMA2D_BG_InitStructure);
+  DMA2D_BG_InitStructure.DMA2D_BGMA = (uint32_t)dst;
+  DMA2D_BG_InitStructure.DMA2D_BGO  = dstSkip;
+  DMA2D_BG_InitStructure.DMA2D_BGCM = CM_RGB565;
+  DMA2D_BGConfig(&DMA2D_BG_InitStructure);
+
+  DMA2D_StartTransfer();
+}
+/**
+ * @brief Sets the mode and output of the next transfer.
+ * @details Waits for the previous transfer.
+ * @param mode DMA2D mode
+ * @param dst First pixel of the output
+ * @param dstSkip Pixels skipped after each output line
+ * @param w Width
+ * @param h Height
+ * @param color Color for register to memory mode
+ */
+static void GFX_HAL_Output(uint32_t mode, uint16_t* dst, uint16_t dstSkip,
+    uint16_t w, uint16_t h, uint16_t color) {
+
+  DMA2D_InitTypeDef DMA2D_InitStructure;
+
+  while (GFX_HAL_IsBusy());
+
+  DMA2D_StructInit(&DMA2D_InitStructure);
+  DMA2D_InitStructure.DMA2D_Mode          = mode;
+  DMA2D_InitStructure.DMA2D_CMode         = DMA2D_RGB565;
+  DMA2D_InitStructure.DMA2D_OutputRed     = (color >> 11) & 0x1f;
+  DMA2D_InitStructure.DMA2D_OutputGreen   = (color >> 5) & 0x3f;
+  DMA2D_InitStructure.DMA2D_OutputBlue    = color & 0x1f;
+  DMA2D_InitStructure.DMA2D_OutputMemoryAdd = (uint32_t)dst;
+  DMA2D_InitStructure.DMA2D_OutputOffset  = dstSkip;
+  DMA2D_InitStructure.DMA2D_NumberOfLine  = h;
+  DMA2D_InitStructure.DMA2D_PixelPerLine  = w;
+  DMA2D_Init(&DMA2D_InitStructure);
+}
+
+#endif /* GFX_DMA2D */
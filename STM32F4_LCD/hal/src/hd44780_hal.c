@@ -16,20 +16,57 @@
  */
 
 #include <hd44780_hal.h>
+#include <tft_hal.h>
+
+#ifndef LCD_I2C // the I2C backpack is in hd44780_hal_i2c.c
 
 #include <stm32f4xx.h>
 
 /*
- * Ports and pins of the LCD
+ * Ports and pins of the LCD. Data and control lines
+ * have to be on the same port, so that a whole nibble
+ * (or byte) with RS and RW can be set in one BSRR store.
+ */
+#ifdef LCD_8BIT
+
+/*
+ * GPIOB isn't free on the Discovery board: PB2 is BOOT1,
+ * PB9 is SDA of the CS43L22 audio DAC and PB10 is the clock
+ * of the MP45DT02 microphone - don't use these parts (and
+ * keep the BOOT1 jumper at 0) with the 8-bit bus. PB10 and
+ * PB12-PB15 are also used by the SPI TFT (tft_hal.c).
+ */
+#ifdef TFT_ENABLE
+  #error "8-bit LCD bus and SPI TFT share PB10, PB12-PB15!"
+#endif
+
+#define LCD_PORT  GPIOB                 ///< LCD GPIO
+#define LCD_CLK   RCC_AHB1Periph_GPIOB  ///< LCD RCC bit
+
+#define LCD_RS  GPIO_Pin_0 ///< Register select pin
+#define LCD_RW  GPIO_Pin_1 ///< Read/write pin (unused with LCD_WRITE_ONLY)
+#define LCD_E0  GPIO_Pin_2 ///< Enable pin of display 0
+#define LCD_E1  GPIO_Pin_4 ///< Enable pin of display 1
+#define LCD_E2  GPIO_Pin_5 ///< Enable pin of display 2
+#define LCD_E3  GPIO_Pin_7 ///< Enable pin of display 3
+
+/*
+ * We use the 8-bit interface - D0..D7 on consecutive pins
  */
-#define LCD_DATA_PORT GPIOD                 ///< LCD data GPIO
-#define LCD_DATA_CLK  RCC_AHB1Periph_GPIOD  ///< LCD data RCC bit
-#define LCD_CTRL_PORT GPIOD                 ///< LCD control GPIO
-#define LCD_CTRL_CLK  RCC_AHB1Periph_GPIOD  ///< LCD control RCC bit
+#define LCD_DATA_SHIFT  8 ///< Pin number of D0 (PB8..PB15)
+#define LCD_DATA_PINS   ((uint16_t)(0xff << LCD_DATA_SHIFT)) ///< All data pins
+
+#else
+
+#define LCD_PORT  GPIOD                 ///< LCD GPIO
+#define LCD_CLK   RCC_AHB1Periph_GPIOD  ///< LCD RCC bit
 
 #define LCD_RS  GPIO_Pin_4 ///< Register select pin
-#define LCD_RW  GPIO_Pin_5 ///< Read/write pin
-#define LCD_E   GPIO_Pin_6 ///< Enable pin
+#define LCD_RW  GPIO_Pin_5 ///< Read/write pin (unused with LCD_WRITE_ONLY)
+#define LCD_E0  GPIO_Pin_6 ///< Enable pin of display 0
+#define LCD_E1  GPIO_Pin_7 ///< Enable pin of display 1
+#define LCD_E2  GPIO_Pin_8 ///< Enable pin of display 2
+#define LCD_E3  GPIO_Pin_9 ///< Enable pin of display 3
 
 /*
  * We use the 4-bit interface
@@ -39,124 +76,320 @@
 #define LCD_D6  GPIO_Pin_2 ///< Data 6 pin
 #define LCD_D7  GPIO_Pin_3 ///< Data 7 pin
 
+#define LCD_DATA_PINS (LCD_D4|LCD_D5|LCD_D6|LCD_D7) ///< All data pins
+
+#endif
+
+/*
+ * Enable pins of the displays in use - the other ones stay free.
+ */
+#if LCD_DISPLAYS == 1
+  #define LCD_E_PINS (LCD_E0)                       ///< All enable pins
+#elif LCD_DISPLAYS == 2
+  #define LCD_E_PINS (LCD_E0|LCD_E1)                ///< All enable pins
+#elif LCD_DISPLAYS == 3
+  #define LCD_E_PINS (LCD_E0|LCD_E1|LCD_E2)         ///< All enable pins
+#else
+  #define LCD_E_PINS (LCD_E0|LCD_E1|LCD_E2|LCD_E3)  ///< All enable pins
+#endif
+
+#ifdef LCD_WRITE_ONLY
+  #define LCD_CTRL_PINS (LCD_RS|LCD_E_PINS)         ///< Control pins driven by the MCU
+  #define LCD_RW_LOW    0                           ///< RW is tied to ground
+#else
+  #define LCD_CTRL_PINS (LCD_RS|LCD_RW|LCD_E_PINS)  ///< Control pins driven by the MCU
+  #define LCD_RW_LOW    ((uint32_t)LCD_RW << 16)    ///< BSRR bit resetting RW
+#endif
+
+#define LCD_BSRR (*(__IO uint32_t*)&LCD_PORT->BSRRL) ///< Whole 32-bit BSRR of LCD port
+
+/*
+ * Bus timings of the HD44780 (as per datasheet). The delay
+ * loops are counted from SystemCoreClock in LCD_HAL_Init.
+ */
+#define LCD_T_AS        40  ///< Address setup time - RS, RW to E rising edge in ns
+#define LCD_T_PW        230 ///< E pulse width in ns (data valid 160ns after E rising edge)
+#define LCD_LOOP_CYCLES 3   ///< Minimum CPU cycles of one delay loop pass
+
+/**
+ * @brief Delay loop passes lasting at least the given time.
+ */
+#define LCD_DELAY_LOOPS(ns) \
+  ((SystemCoreClock / 1000000 * (ns) + LCD_LOOP_CYCLES * 1000 - 1) / (LCD_LOOP_CYCLES * 1000))
+
+/**
+ * @brief BSRR word for the RS line.
+ */
+#define LCD_BSRR_RS(rs) ((rs) ? (uint32_t)LCD_RS : ((uint32_t)LCD_RS << 16))
+
+#ifdef LCD_8BIT
+
+/**
+ * @brief BSRR word putting a byte on D0..D7.
+ */
+#define LCD_BSRR_BYTE(data) (((uint32_t)(data) << LCD_DATA_SHIFT) | \
+    ((uint32_t)(uint8_t)~(data) << (LCD_DATA_SHIFT + 16)))
+
+#else
+
+/**
+ * @brief BSRR word setting or resetting a single data pin.
+ */
+#define LCD_BSRR_BIT(nibble, bit, pin) \
+  (((nibble) & (1<<(bit))) ? (uint32_t)(pin) : ((uint32_t)(pin) << 16))
+
+/**
+ * @brief BSRR word putting a nibble on D4..D7.
+ */
+#define LCD_BSRR_NIBBLE(n) (LCD_BSRR_BIT(n, 0, LCD_D4) | LCD_BSRR_BIT(n, 1, LCD_D5) | \
+    LCD_BSRR_BIT(n, 2, LCD_D6) | LCD_BSRR_BIT(n, 3, LCD_D7))
+
+/**
+ * @brief Lookup table of BSRR words for every nibble value.
+ */
+static const uint32_t lcdNibbleBsrr[16] = {
+  LCD_BSRR_NIBBLE(0),  LCD_BSRR_NIBBLE(1),  LCD_BSRR_NIBBLE(2),  LCD_BSRR_NIBBLE(3),
+  LCD_BSRR_NIBBLE(4),  LCD_BSRR_NIBBLE(5),  LCD_BSRR_NIBBLE(6),  LCD_BSRR_NIBBLE(7),
+  LCD_BSRR_NIBBLE(8),  LCD_BSRR_NIBBLE(9),  LCD_BSRR_NIBBLE(10), LCD_BSRR_NIBBLE(11),
+  LCD_BSRR_NIBBLE(12), LCD_BSRR_NIBBLE(13), LCD_BSRR_NIBBLE(14), LCD_BSRR_NIBBLE(15),
+};
+
+#endif
+
+/**
+ * @brief Enable pins of the displays.
+ */
+static const uint16_t lcdEnablePins[] = {
+  LCD_E0, LCD_E1, LCD_E2, LCD_E3,
+};
+
+static uint16_t lcdE = LCD_E0; ///< Enable pin of selected display
+static uint8_t initialized;    ///< Were the pins set up?
+static uint32_t setupLoops;    ///< Delay loop passes for the address setup time
+static uint32_t pulseLoops;    ///< Delay loop passes for the E pulse width
+
+#ifndef LCD_WRITE_ONLY
+static uint32_t dataModerMask; ///< MODER bits of the data pins
+static uint32_t dataModerOut;  ///< MODER value of the data pins as outputs
+#endif
+
+/**
+ * @brief Short busy wait for LCD bus timings.
+ * @param loops Number of delay loop passes
+ */
+static inline void LCD_HAL_Wait(uint32_t loops) {
+
+  uint32_t i;
+  for (i = 0; i < loops; i++) {
+    __NOP();
+  }
+}
+
 /**
  * @brief Low level initalization of the LCD.
+ * @details Sets up the pins of all displays (only once,
+ * all displays share the bus).
  */
 void LCD_HAL_Init(void) {
 
-  // enable clocks for GPIOs
-  RCC_AHB1PeriphClockCmd(LCD_DATA_CLK, ENABLE);
-  RCC_AHB1PeriphClockCmd(LCD_CTRL_CLK, ENABLE);
+  if (initialized) {
+    return;
+  }
+  initialized = 1;
 
-  // Set LCD data pins initially as output
-  LCD_HAL_DataOut();
+  setupLoops = LCD_DELAY_LOOPS(LCD_T_AS);
+  pulseLoops = LCD_DELAY_LOOPS(LCD_T_PW);
 
-  // Set control pins as output
+  // enable clocks for GPIOs
+  RCC_AHB1PeriphClockCmd(LCD_CLK, ENABLE);
+
+  // Set data and control pins as output. Data pins get
+  // pull ups for reading the busy flag.
   GPIO_InitTypeDef GPIO_InitStructure;
-  GPIO_InitStructure.GPIO_Pin   = (LCD_RS|LCD_RW|LCD_E);
+  GPIO_InitStructure.GPIO_Pin   = LCD_DATA_PINS;
   GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_OUT;
   GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
   GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_UP;
+  GPIO_Init(LCD_PORT, &GPIO_InitStructure);
+
+  GPIO_InitStructure.GPIO_Pin   = LCD_CTRL_PINS;
   GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_NOPULL;
-  GPIO_Init(LCD_CTRL_PORT,&GPIO_InitStructure);
+  GPIO_Init(LCD_PORT, &GPIO_InitStructure);
 
   // Clear all control signals initially
-  GPIO_ResetBits(LCD_CTRL_PORT, LCD_RW|LCD_RS|LCD_E);
+  LCD_BSRR = (uint32_t)LCD_CTRL_PINS << 16;
 
+#ifndef LCD_WRITE_ONLY
+  // MODER bits for switching data lines between input and output
+  uint8_t i;
+  for (i = 0; i < 16; i++) {
+    if (LCD_DATA_PINS & (1<<i)) {
+      dataModerMask |= 0x03UL << (2*i);
+      dataModerOut  |= 0x01UL << (2*i);
+    }
+  }
+#endif
 }
 
-void LCD_HAL_LowRS(void) {
-  GPIO_ResetBits(LCD_CTRL_PORT, LCD_RS);
-}
-void LCD_HAL_HighRS(void) {
-  GPIO_SetBits(LCD_CTRL_PORT, LCD_RS);
-}
-void LCD_HAL_LowRW(void) {
-  GPIO_ResetBits(LCD_CTRL_PORT, LCD_RW);
+/**
+ * @brief Selects the display strobed by the following transfers.
+ * @param display Display number
+ */
+void LCD_HAL_Select(uint8_t display) {
+
+  if (display < LCD_DISPLAYS) {
+    lcdE = lcdEnablePins[display];
+  }
 }
-void LCD_HAL_HighRW(void) {
-  GPIO_SetBits(LCD_CTRL_PORT, LCD_RW);
+
+/**
+ * @brief Pulses the E line - data is latched on the falling edge.
+ * @details RS and RW have to be set before the call.
+ */
+static void LCD_HAL_Strobe(void) {
+
+  LCD_HAL_Wait(setupLoops); // RS and RW settle before E rises
+  LCD_BSRR = lcdE;
+  LCD_HAL_Wait(pulseLoops);
+  LCD_BSRR = (uint32_t)lcdE << 16;
+  LCD_HAL_Wait(pulseLoops);
 }
-void LCD_HAL_HighE(void) {
-  GPIO_SetBits(LCD_CTRL_PORT, LCD_E);
+
+#ifdef LCD_8BIT
+
+/**
+ * @brief Writes a nibble on D4..D7 (one E strobe).
+ * @details Used only in the initialization sequence,
+ * D0..D3 are low.
+ * @param nibble Data in lower 4 bits
+ * @param rs Register select: 0 - command, 1 - data
+ */
+void LCD_HAL_WriteNibble(uint8_t nibble, uint8_t rs) {
+
+  LCD_BSRR = LCD_BSRR_BYTE((nibble & 0x0f) << 4) | LCD_RW_LOW | LCD_BSRR_RS(rs);
+  LCD_HAL_Strobe();
 }
-void LCD_HAL_LowE(void) {
-  GPIO_ResetBits(LCD_CTRL_PORT, LCD_E);
+
+/**
+ * @brief Sends a byte to the LCD.
+ * @details Data, RS and RW are set in one store, then E is pulsed once.
+ * @param data Data or command
+ * @param rs Register select: 0 - command, 1 - data
+ */
+void LCD_HAL_Send(uint8_t data, uint8_t rs) {
+
+  LCD_BSRR = LCD_BSRR_BYTE(data) | LCD_RW_LOW | LCD_BSRR_RS(rs);
+  LCD_HAL_Strobe();
 }
 
+#else
+
 /**
- * @brief Set data lines as output.
+ * @brief Writes a single nibble to the LCD (one E strobe).
+ * @details Data, RS and RW are set in one store, then E is pulsed.
+ * @param nibble Data in lower 4 bits
+ * @param rs Register select: 0 - command, 1 - data
  */
-void LCD_HAL_DataOut(void) {
-  GPIO_InitTypeDef GPIO_InitStructure;
+void LCD_HAL_WriteNibble(uint8_t nibble, uint8_t rs) {
 
-  GPIO_InitStructure.GPIO_Pin   = (LCD_D4|LCD_D5|LCD_D6|LCD_D7);
-  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_OUT;
-  GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
-  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_NOPULL;
-  GPIO_Init(LCD_DATA_PORT, &GPIO_InitStructure);
+  LCD_BSRR = lcdNibbleBsrr[nibble & 0x0f] | LCD_RW_LOW | LCD_BSRR_RS(rs);
+  LCD_HAL_Strobe();
 }
 
 /**
- * @brief Set data lines as input with pull up
+ * @brief Sends a byte to the LCD (higher nibble first).
+ * @param data Data or command
+ * @param rs Register select: 0 - command, 1 - data
  */
-void LCD_HAL_DataIn(void) {
-  GPIO_InitTypeDef GPIO_InitStructure;
+void LCD_HAL_Send(uint8_t data, uint8_t rs) {
 
-  GPIO_InitStructure.GPIO_Pin   = (LCD_D4|LCD_D5|LCD_D6|LCD_D7);
-  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_IN;
-  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
-  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_UP;
-  GPIO_Init(LCD_DATA_PORT,&GPIO_InitStructure);
+  LCD_HAL_WriteNibble(data >> 4, rs);
+  LCD_HAL_WriteNibble(data, rs);
 }
 
+#endif
+
+#ifndef LCD_WRITE_ONLY
+
 /**
- * @brief This functions sets data on the data lines when writing.
- * @param data Data to write
+ * @brief Reads the data lines during a read cycle.
+ * @return Value of the IDR register while E is high
  */
-void LCD_HAL_Write(uint8_t data) {
+static uint16_t LCD_HAL_ReadCycle(void) {
 
-  // set the various bits
-  if (data & (1<<3))
-    GPIO_SetBits(LCD_DATA_PORT, LCD_D7);
-  else
-    GPIO_ResetBits(LCD_DATA_PORT, LCD_D7);
+  LCD_HAL_Wait(setupLoops); // RS and RW settle before E rises
+  LCD_BSRR = lcdE;
+  LCD_HAL_Wait(pulseLoops); // data valid 160ns after E rising edge
 
-  if (data & (1<<2))
-    GPIO_SetBits(LCD_DATA_PORT, LCD_D6);
-  else
-    GPIO_ResetBits(LCD_DATA_PORT, LCD_D6);
+  uint16_t idr = LCD_PORT->IDR;
 
-  if (data & (1<<1))
-    GPIO_SetBits(LCD_DATA_PORT, LCD_D5);
-  else
-    GPIO_ResetBits(LCD_DATA_PORT, LCD_D5);
+  LCD_BSRR = (uint32_t)lcdE << 16;
+  LCD_HAL_Wait(pulseLoops);
 
-  if (data & (1<<0))
-    GPIO_SetBits(LCD_DATA_PORT, LCD_D4);
-  else
-    GPIO_ResetBits(LCD_DATA_PORT, LCD_D4);
+  return idr;
 }
 
+#ifndef LCD_8BIT
 /**
- * @brief Reads the data lines
- * @return Read data.
+ * @brief Reads one nibble during a read cycle.
+ * @return Nibble read from D4..D7
  */
-uint8_t LCD_HAL_Read(void) {
-  uint8_t result = 0;
+static uint8_t LCD_HAL_ReadNibble(void) {
 
-  GPIO_SetBits(LCD_CTRL_PORT, LCD_E);
+  uint8_t result = 0;
+  uint16_t idr = LCD_HAL_ReadCycle();
 
-  if(GPIO_ReadInputDataBit(LCD_DATA_PORT,LCD_D7))
+  if (idr & LCD_D7)
     result |= (1<<3);
-  if(GPIO_ReadInputDataBit(LCD_DATA_PORT,LCD_D6))
+  if (idr & LCD_D6)
     result |= (1<<2);
-  if(GPIO_ReadInputDataBit(LCD_DATA_PORT,LCD_D5))
+  if (idr & LCD_D5)
     result |= (1<<1);
-  if(GPIO_ReadInputDataBit(LCD_DATA_PORT,LCD_D4))
+  if (idr & LCD_D4)
     result |= (1<<0);
 
-  GPIO_ResetBits(LCD_CTRL_PORT, LCD_E);
   return result;
 }
+#endif
+
+/**
+ * @brief Reads the busy flag and address counter.
+ * @details Data lines are switched to inputs only for the
+ * time of the read (by writing MODER directly).
+ * @return Status byte (busy flag is bit 7)
+ */
+uint8_t LCD_HAL_ReadStatus(void) {
+
+  uint8_t result;
+
+  LCD_PORT->MODER &= ~dataModerMask; // data lines as input
+  LCD_BSRR = ((uint32_t)LCD_RS << 16) | LCD_RW; // rs low, rw high - read
+
+#ifdef LCD_8BIT
+  result  = LCD_HAL_ReadCycle() >> LCD_DATA_SHIFT;
+#else
+  result  = LCD_HAL_ReadNibble() << 4;
+  result |= LCD_HAL_ReadNibble();
+#endif
+
+  LCD_BSRR = LCD_RW_LOW; // back to writing before driving the bus
+  LCD_PORT->MODER |= dataModerOut;
+
+  return result;
+}
+
+#else
+
+/**
+ * @brief Returns the number of transfers waiting to be sent.
+ * @details GPIO transfers are made at once, so nothing waits.
+ * @return Always 0
+ */
+uint8_t LCD_HAL_Queued(void) {
+  return 0;
+}
+
+#endif /* LCD_WRITE_ONLY */
+
+#endif /* LCD_I2C */
@@ -0,0 +1,402 @@
+/**
+ * @file:   hd44780_hal_i2c.c
+ * @brief:  HD44780 behind a PCF8574 I2C backpack
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Every nibble is written to the expander twice - with E high
+ * and with E low - so a byte takes 4 bytes on I2C. They are
+ * collected in a buffer of the display and sent by DMA in one
+ * transaction, while the next ones are collected in a second
+ * buffer. At 400kHz a byte for the LCD takes 90us on the bus,
+ * more than any short instruction, so they can follow each
+ * other without waiting. Clear and home are timed by the driver
+ * from the moment the transport is empty (see LCD_IsBusy).
+ *
+ * Interrupts only end a transaction with a STOP. The next one
+ * is started from LCD_HAL_Push or LCD_HAL_Update (called in
+ * LCD_Update), once the STOP has left the bus, so no interrupt
+ * waits for the bus.
+ *
+ * Displays on the bus have consecutive expander addresses
+ * going down from LCD_I2C_ADDRESS.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <hd44780_hal.h>
+
+#ifdef LCD_I2C
+
+#include <stm32f4xx.h>
+
+#define LCD_I2C_PERIPH    I2C1                  ///< I2C peripheral
+#define LCD_I2C_CLK       RCC_APB1Periph_I2C1   ///< I2C RCC bit
+#define LCD_I2C_SPEED     400000                ///< I2C clock in Hz
+#define LCD_I2C_EV_IRQ    I2C1_EV_IRQn          ///< I2C event interrupt
+#define LCD_I2C_ER_IRQ    I2C1_ER_IRQn          ///< I2C error interrupt
+
+#define LCD_I2C_PORT      GPIOB                 ///< SCL and SDA GPIO
+#define LCD_I2C_PORT_CLK  RCC_AHB1Periph_GPIOB  ///< GPIO RCC bit
+#define LCD_I2C_SCL       GPIO_Pin_6            ///< SCL pin
+#define LCD_I2C_SDA       GPIO_Pin_9            ///< SDA pin
+#define LCD_I2C_SCL_SRC   GPIO_PinSource6       ///< SCL pin source
+#define LCD_I2C_SDA_SRC   GPIO_PinSource9       ///< SDA pin source
+#define LCD_I2C_AF        GPIO_AF_I2C1          ///< Alternate function
+
+#define LCD_I2C_DMA_CLK     RCC_AHB1Periph_DMA1 ///< DMA RCC bit
+#define LCD_I2C_DMA_STREAM  DMA1_Stream6        ///< I2C1 TX stream
+#define LCD_I2C_DMA_CHANNEL DMA_Channel_1       ///< I2C1 TX channel
+#define LCD_I2C_DMA_IRQ     DMA1_Stream6_IRQn   ///< DMA stream interrupt
+#define LCD_I2C_DMA_TC      DMA_IT_TCIF6        ///< Transfer complete flag
+#define LCD_I2C_DMA_FLAGS   (DMA_FLAG_TCIF6|DMA_FLAG_HTIF6|DMA_FLAG_TEIF6| \
+    DMA_FLAG_DMEIF6|DMA_FLAG_FEIF6)             ///< All flags of the stream
+
+#define LCD_I2C_ADDRESS   0x27 ///< 7-bit address of the expander of display 0
+
+/*
+ * Expander pins (common backpack wiring)
+ */
+#define LCD_PCF_RS  0x01 ///< P0 - register select
+#define LCD_PCF_RW  0x02 ///< P1 - read/write (kept low)
+#define LCD_PCF_E   0x04 ///< P2 - enable
+#define LCD_PCF_BL  0x08 ///< P3 - backlight
+                         // P4..P7 - D4..D7
+
+#define LCD_HAL_DISPLAYS  4                         ///< Number of expanders on the bus
+#define LCD_I2C_BUF_LEN   (LCD_HAL_QUEUE_LEN * 4)   ///< Bytes in one buffer
+#define LCD_I2C_IDLE      0xff                      ///< No transaction on the bus
+
+/**
+ * @brief Transfers of one display.
+ */
+typedef struct {
+  uint8_t buf[2][LCD_I2C_BUF_LEN];  ///< Buffer being sent and buffer being filled
+  volatile uint16_t len[2];         ///< Number of bytes in the buffers
+  volatile uint8_t fill;            ///< Buffer being filled
+} LCD_I2C_Queue_TypeDef;
+
+static LCD_I2C_Queue_TypeDef queues[LCD_HAL_DISPLAYS]; ///< Queues of all displays
+static LCD_I2C_Queue_TypeDef* queue = &queues[0];     ///< Queue of selected display
+
+static volatile uint8_t sending = LCD_I2C_IDLE; ///< Display whose buffer is sent
+static uint8_t sendingBuf;                      ///< Buffer being sent
+static uint8_t initialized;                     ///< Was the hardware set up?
+
+static void LCD_HAL_InitI2C(void);
+static void LCD_HAL_Push(uint8_t* bytes, uint8_t count);
+static void LCD_HAL_Restart(void);
+static void LCD_HAL_StartBurst(void);
+static void LCD_HAL_EndBurst(void);
+
+/**
+ * @brief Low level initalization of the LCD.
+ * @details Sets up I2C1 and its DMA stream (only once,
+ * all displays share the bus).
+ */
+void LCD_HAL_Init(void) {
+
+  if (initialized) {
+    return;
+  }
+  initialized = 1;
+
+  GPIO_InitTypeDef  GPIO_InitStructure;
+  DMA_InitTypeDef   DMA_InitStructure;
+
+  // Enable clocks for peripherals
+  RCC_APB1PeriphClockCmd(LCD_I2C_CLK, ENABLE);
+  RCC_AHB1PeriphClockCmd(LCD_I2C_PORT_CLK | LCD_I2C_DMA_CLK, ENABLE);
+
+  // SCL and SDA - open drain
+  GPIO_InitStructure.GPIO_Pin   = LCD_I2C_SCL | LCD_I2C_SDA;
+  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_AF;
+  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+  GPIO_InitStructure.GPIO_OType = GPIO_OType_OD;
+  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_UP;
+  GPIO_Init(LCD_I2C_PORT, &GPIO_InitStructure);
+
+  GPIO_PinAFConfig(LCD_I2C_PORT, LCD_I2C_SCL_SRC, LCD_I2C_AF);
+  GPIO_PinAFConfig(LCD_I2C_PORT, LCD_I2C_SDA_SRC, LCD_I2C_AF);
+
+  LCD_HAL_InitI2C();
+
+  // DMA - memory to I2C data register, address and length
+  // are set for every burst
+  DMA_StructInit(&DMA_InitStructure);
+  DMA_InitStructure.DMA_Channel            = LCD_I2C_DMA_CHANNEL;
+  DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&LCD_I2C_PERIPH->DR;
+  DMA_InitStructure.DMA_Memory0BaseAddr    = (uint32_t)queues[0].buf[0];
+  DMA_InitStructure.DMA_DIR                = DMA_DIR_MemoryToPeripheral;
+  DMA_InitStructure.DMA_BufferSize         = 1;
+  DMA_InitStructure.DMA_PeripheralInc      = DMA_PeripheralInc_Disable;
+  DMA_InitStructure.DMA_MemoryInc          = DMA_MemoryInc_Enable;
+  DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Byte;
+  DMA_InitStructure.DMA_MemoryDataSize     = DMA_MemoryDataSize_Byte;
+  DMA_InitStructure.DMA_Mode               = DMA_Mode_Normal;
+  DMA_InitStructure.DMA_Priority           = DMA_Priority_Medium;
+  DMA_Init(LCD_I2C_DMA_STREAM, &DMA_InitStructure);
+
+  DMA_ITConfig(LCD_I2C_DMA_STREAM, DMA_IT_TC, ENABLE);
+
+  NVIC_EnableIRQ(LCD_I2C_EV_IRQ);
+  NVIC_EnableIRQ(LCD_I2C_ER_IRQ);
+  NVIC_EnableIRQ(LCD_I2C_DMA_IRQ);
+}
+
+/**
+ * @brief Sets up the I2C peripheral.
+ * @details Called again after a reset of the peripheral.
+ */
+static void LCD_HAL_InitI2C(void) {
+
+  I2C_InitTypeDef I2C_InitStructure;
+
+  I2C_StructInit(&I2C_InitStructure);
+  I2C_InitStructure.I2C_Mode        = I2C_Mode_I2C;
+  I2C_InitStructure.I2C_DutyCycle   = I2C_DutyCycle_2;
+  I2C_InitStructure.I2C_Ack         = I2C_Ack_Enable;
+  I2C_InitStructure.I2C_ClockSpeed  = LCD_I2C_SPEED;
+  I2C_InitStructure.I2C_AcknowledgedAddress = I2C_AcknowledgedAddress_7bit;
+  I2C_Init(LCD_I2C_PERIPH, &I2C_InitStructure);
+
+  I2C_Cmd(LCD_I2C_PERIPH, ENABLE);
+  I2C_DMACmd(LCD_I2C_PERIPH, ENABLE);          // TXE requests DMA
+  I2C_ITConfig(LCD_I2C_PERIPH, I2C_IT_ERR, ENABLE);
+}
+
+/**
+ * @brief Selects the display (expander) of the following transfers.
+ * @param display Display number
+ */
+void LCD_HAL_Select(uint8_t display) {
+
+  if (display < LCD_HAL_DISPLAYS) {
+    queue = &queues[display];
+  }
+}
+
+/**
+ * @brief Writes a single nibble to the LCD (one E strobe).
+ * @param nibble Data in lower 4 bits
+ * @param rs Register select: 0 - command, 1 - data
+ */
+void LCD_HAL_WriteNibble(uint8_t nibble, uint8_t rs) {
+
+  uint8_t out = (nibble << 4) | LCD_PCF_BL | (rs ? LCD_PCF_RS : 0);
+  uint8_t bytes[2] = {out | LCD_PCF_E, out};
+
+  LCD_HAL_Push(bytes, 2);
+}
+
+/**
+ * @brief Sends a byte to the LCD (higher nibble first).
+ * @param data Data or command
+ * @param rs Register select: 0 - command, 1 - data
+ */
+void LCD_HAL_Send(uint8_t data, uint8_t rs) {
+
+  uint8_t ctrl = LCD_PCF_BL | (rs ? LCD_PCF_RS : 0);
+  uint8_t high = (data & 0xf0) | ctrl;
+  uint8_t low  = (data << 4) | ctrl;
+  uint8_t bytes[4] = {high | LCD_PCF_E, high, low | LCD_PCF_E, low};
+
+  LCD_HAL_Push(bytes, 4);
+}
+
+/**
+ * @brief Returns the number of transfers waiting to be sent.
+ * @details Counts transfers of the selected display still
+ * in the buffers (including the one on the bus).
+ * @return Number of transfers
+ */
+uint8_t LCD_HAL_Queued(void) {
+  return (queue->len[0] + queue->len[1] + 3) / 4;
+}
+
+/**
+ * @brief Starts the next transaction if the bus is idle.
+ * @details Has to be called in the main loop - interrupts
+ * don't start transactions.
+ */
+void LCD_HAL_Update(void) {
+
+  __disable_irq();
+  LCD_HAL_Restart();
+  __enable_irq();
+}
+
+/**
+ * @brief Appends bytes to the buffer of the selected display.
+ * @details Starts a transaction if the bus is idle. Bytes
+ * that don't fit are dropped (the driver never sends more
+ * than LCD_HAL_QUEUE_LEN transfers ahead).
+ * @param bytes Bytes for the expander
+ * @param count Number of bytes
+ */
+static void LCD_HAL_Push(uint8_t* bytes, uint8_t count) {
+
+  __disable_irq(); // buffers are swapped in interrupts
+
+  uint8_t fill = queue->fill;
+  uint16_t len = queue->len[fill];
+
+  if (len + count <= LCD_I2C_BUF_LEN) {
+    uint8_t i;
+    for (i = 0; i < count; i++) {
+      queue->buf[fill][len + i] = bytes[i];
+    }
+    queue->len[fill] = len + count;
+  }
+
+  LCD_HAL_Restart();
+
+  __enable_irq();
+}
+
+/**
+ * @brief Starts a transaction if there is none and the STOP
+ * of the last one was sent (START can't be set before).
+ * @details Called with interrupts disabled.
+ */
+static void LCD_HAL_Restart(void) {
+
+  if (sending == LCD_I2C_IDLE && !(LCD_I2C_PERIPH->CR1 & I2C_CR1_STOP)) {
+    LCD_HAL_StartBurst();
+  }
+}
+
+/**
+ * @brief Starts sending the next filled buffer.
+ * @details Displays are served in turns. The buffer being filled
+ * is swapped, so new bytes go to the other one.
+ */
+static void LCD_HAL_StartBurst(void) {
+
+  static uint8_t last; // display sent last
+  uint8_t i;
+
+  for (i = 1; i <= LCD_HAL_DISPLAYS; i++) {
+
+    uint8_t display = (last + i) % LCD_HAL_DISPLAYS;
+    LCD_I2C_Queue_TypeDef* q = &queues[display];
+
+    if (q->len[q->fill]) {
+      last       = display;
+      sending    = display;
+      sendingBuf = q->fill;
+      q->fill   ^= 1;
+
+      // address and DMA follow in the event interrupt
+      I2C_ITConfig(LCD_I2C_PERIPH, I2C_IT_EVT, ENABLE);
+      I2C_GenerateSTART(LCD_I2C_PERIPH, ENABLE);
+      return;
+    }
+  }
+
+  sending = LCD_I2C_IDLE;
+}
+
+/**
+ * @brief Ends the transaction.
+ * @details The next one is started by LCD_HAL_Restart.
+ */
+static void LCD_HAL_EndBurst(void) {
+
+  I2C_ITConfig(LCD_I2C_PERIPH, I2C_IT_EVT, DISABLE);
+  I2C_GenerateSTOP(LCD_I2C_PERIPH, ENABLE);
+
+  queues[sending].len[sendingBuf] = 0;
+  sending = LCD_I2C_IDLE;
+}
+
+/**
+ * @brief IRQ handler for I2C1 events.
+ */
+void I2C1_EV_IRQHandler(void) {
+
+  switch (I2C_GetLastEvent(LCD_I2C_PERIPH)) {
+
+  // START sent - send the expander address
+  case I2C_EVENT_MASTER_MODE_SELECT:
+    I2C_Send7bitAddress(LCD_I2C_PERIPH, (LCD_I2C_ADDRESS - sending) << 1,
+        I2C_Direction_Transmitter);
+    break;
+
+  // Address acknowledged - DMA sends the buffer
+  case I2C_EVENT_MASTER_TRANSMITTER_MODE_SELECTED:
+    I2C_ITConfig(LCD_I2C_PERIPH, I2C_IT_EVT, DISABLE);
+    DMA_ClearFlag(LCD_I2C_DMA_STREAM, LCD_I2C_DMA_FLAGS);
+    DMA_MemoryTargetConfig(LCD_I2C_DMA_STREAM,
+        (uint32_t)queues[sending].buf[sendingBuf], DMA_Memory_0);
+    DMA_SetCurrDataCounter(LCD_I2C_DMA_STREAM, queues[sending].len[sendingBuf]);
+    DMA_Cmd(LCD_I2C_DMA_STREAM, ENABLE);
+    break;
+
+  // Last byte shifted out
+  case I2C_EVENT_MASTER_BYTE_TRANSMITTED:
+    LCD_HAL_EndBurst();
+    break;
+
+  default:
+    break;
+  }
+}
+
+/**
+ * @brief IRQ handler for I2C1 errors.
+ * @details A missing expander doesn't acknowledge its address -
+ * its buffer is dropped so the other displays still work.
+ * After a bus error or lost arbitration the state of the bus
+ * is unknown - the peripheral is reset and the buffer dropped.
+ */
+void I2C1_ER_IRQHandler(void) {
+
+  uint16_t sr1 = LCD_I2C_PERIPH->SR1;
+
+  // all error flags are cleared by writing 0
+  I2C_ClearITPendingBit(LCD_I2C_PERIPH, I2C_IT_BERR | I2C_IT_ARLO |
+      I2C_IT_AF | I2C_IT_OVR | I2C_IT_TIMEOUT);
+
+  if (sr1 & (I2C_SR1_BERR | I2C_SR1_ARLO)) {
+
+    DMA_Cmd(LCD_I2C_DMA_STREAM, DISABLE);
+    DMA_ClearFlag(LCD_I2C_DMA_STREAM, LCD_I2C_DMA_FLAGS);
+
+    I2C_SoftwareResetCmd(LCD_I2C_PERIPH, ENABLE);
+    I2C_SoftwareResetCmd(LCD_I2C_PERIPH, DISABLE);
+    LCD_HAL_InitI2C();
+
+    if (sending != LCD_I2C_IDLE) {
+      queues[sending].len[sendingBuf] = 0;
+      sending = LCD_I2C_IDLE;
+    }
+
+  } else if ((sr1 & I2C_SR1_AF) && sending != LCD_I2C_IDLE) {
+    DMA_Cmd(LCD_I2C_DMA_STREAM, DISABLE);
+    LCD_HAL_EndBurst();
+  }
+}
+
+/**
+ * @brief IRQ handler for the I2C1 TX DMA stream.
+ */
+void DMA1_Stream6_IRQHandler(void) {
+
+  if (DMA_GetITStatus(LCD_I2C_DMA_STREAM, LCD_I2C_DMA_TC) != RESET) {
+    DMA_ClearITPendingBit(LCD_I2C_DMA_STREAM, LCD_I2C_DMA_TC);
+    DMA_Cmd(LCD_I2C_DMA_STREAM, DISABLE);
+    // wait for BTF - the last byte is still being sent
+    I2C_ITConfig(LCD_I2C_PERIPH, I2C_IT_EVT, ENABLE);
+  }
+}
+
+#endif /* LCD_I2C */
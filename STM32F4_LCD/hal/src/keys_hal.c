@@ -38,6 +38,78 @@
 #define KEYS_COL_PORT   GPIOE
 #define KEYS_COL_CLOCK  RCC_AHB1Periph_GPIOE
 
+/*
+ * Scan timer - TIM7 counts microseconds (84MHz / 84)
+ */
+#define KEYS_TIM            TIM7
+#define KEYS_TIM_CLOCK      RCC_APB1Periph_TIM7
+#define KEYS_TIM_IRQ        TIM7_IRQn
+#define KEYS_TIM_PRESCALER  83
+
+static void (*tickCallback)(void); ///< Called on every scan timer tick
+
+#define KEYS_ROW_PINS (KEYS_ROW0_PIN | KEYS_ROW1_PIN | KEYS_ROW2_PIN | KEYS_ROW3_PIN)
+#define KEYS_COL_PINS (KEYS_COL0_PIN | KEYS_COL1_PIN | KEYS_COL2_PIN | KEYS_COL3_PIN)
+
+#ifdef KEYS_USE_EXTI
+
+/*
+ * Row lines are EXTI lines 11-14 (same numbers as pins)
+ */
+#define KEYS_EXTI_PORT  EXTI_PortSourceGPIOE
+#define KEYS_EXTI_LINES KEYS_ROW_PINS
+#define KEYS_EXTI_IRQ   EXTI15_10_IRQn
+
+static void (*pressCallback)(void); ///< Called when a key is pressed while idle
+
+#endif
+
+#ifdef KEYS_USE_DMA
+
+/*
+ * TIM1 update writes the next column pattern to BSRR (DMA2
+ * Stream5 Channel 6), compare 1 in the middle of the period
+ * samples IDR (DMA2 Stream1 Channel 6). Only DMA2 can reach
+ * the GPIO ports on AHB1. TIM1 counts microseconds (168MHz / 168).
+ */
+#define KEYS_DMA_PERIOD     100                   ///< Time between columns in us
+#define KEYS_DMA_TIM        TIM1
+#define KEYS_DMA_TIM_CLOCK  RCC_APB2Periph_TIM1
+#define KEYS_DMA_PRESCALER  167
+#define KEYS_DMA_CLOCK      RCC_AHB1Periph_DMA2
+#define KEYS_DMA_COL        DMA2_Stream5          ///< TIM1_UP stream
+#define KEYS_DMA_ROW        DMA2_Stream1          ///< TIM1_CH1 stream
+#define KEYS_DMA_CHANNEL    DMA_Channel_6
+
+static uint32_t columnPatterns[KEYS_COLUMNS];   ///< BSRR values selecting each column
+static volatile uint16_t rowSamples[KEYS_COLUMNS]; ///< IDR sampled with each column
+
+static void KEYS_HAL_StartDMA(void);
+
+#endif
+
+/**
+ * @brief Pressed rows in a port value.
+ * @param port Row port input data
+ * @return Pressed rows (bit 0 - row 0)
+ */
+static uint8_t KEYS_HAL_Rows(uint16_t port) {
+
+  uint16_t row = ~port; // low level for keypress
+  uint8_t rows = 0;
+
+  if (row & KEYS_ROW0_PIN)
+    rows |= 1 << 0;
+  if (row & KEYS_ROW1_PIN)
+    rows |= 1 << 1;
+  if (row & KEYS_ROW2_PIN)
+    rows |= 1 << 2;
+  if (row & KEYS_ROW3_PIN)
+    rows |= 1 << 3;
+
+  return rows;
+}
+
 /**
  * @brief Initialize 4x4 matrix keyboard
  */
@@ -69,6 +141,44 @@ void KEYS_HAL_Init(void) {
 
   GPIO_Init(KEYS_COL_PORT, &GPIO_InitStructure);
 
+  RCC_APB1PeriphClockCmd(KEYS_TIM_CLOCK, ENABLE);
+
+  // same priority as the EXTI interrupt - they don't preempt each other
+  NVIC_InitTypeDef NVIC_InitStructure;
+  NVIC_InitStructure.NVIC_IRQChannel = KEYS_TIM_IRQ;
+  NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+  NVIC_InitStructure.NVIC_IRQChannelSubPriority = 1;
+  NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+  NVIC_Init(&NVIC_InitStructure);
+
+#ifdef KEYS_USE_EXTI
+
+  RCC_APB2PeriphClockCmd(RCC_APB2Periph_SYSCFG, ENABLE);
+
+  SYSCFG_EXTILineConfig(KEYS_EXTI_PORT, EXTI_PinSource11);
+  SYSCFG_EXTILineConfig(KEYS_EXTI_PORT, EXTI_PinSource12);
+  SYSCFG_EXTILineConfig(KEYS_EXTI_PORT, EXTI_PinSource13);
+  SYSCFG_EXTILineConfig(KEYS_EXTI_PORT, EXTI_PinSource14);
+
+  // lines stay masked until KEYS_HAL_Idle
+  EXTI_InitTypeDef EXTI_InitStructure;
+  EXTI_InitStructure.EXTI_Line    = KEYS_EXTI_LINES;
+  EXTI_InitStructure.EXTI_Mode    = EXTI_Mode_Interrupt;
+  EXTI_InitStructure.EXTI_Trigger = EXTI_Trigger_Falling;
+  EXTI_InitStructure.EXTI_LineCmd = DISABLE;
+  EXTI_Init(&EXTI_InitStructure);
+
+  NVIC_InitStructure.NVIC_IRQChannel = KEYS_EXTI_IRQ;
+  NVIC_InitStructure.NVIC_IRQChannelPreemptionPriority = 1;
+  NVIC_InitStructure.NVIC_IRQChannelSubPriority = 0;
+  NVIC_InitStructure.NVIC_IRQChannelCmd = ENABLE;
+  NVIC_Init(&NVIC_InitStructure);
+
+#endif
+
+#ifdef KEYS_USE_DMA
+  KEYS_HAL_StartDMA();
+#endif
 }
 /**
  * @brief Select a column
@@ -100,22 +210,202 @@ void KEYS_HAL_SelectColumn(uint8_t col) {
 
 }
 /**
- * @brief Read keyboard row.
- * @return Row value
+ * @brief Read keyboard rows.
+ * @return Pressed rows of the selected column (bit 0 - row 0)
+ */
+uint8_t KEYS_HAL_ReadRows(void) {
+  return KEYS_HAL_Rows(GPIO_ReadInputData(KEYS_ROW_PORT));
+}
+/**
+ * @brief Starts the scan timer.
+ * @param period Time between ticks in us
+ * @param tickCb Function called (in interrupt) on every tick
  */
-int8_t KEYS_HAL_ReadRow(void) {
+void KEYS_HAL_StartTimer(uint32_t period, void (*tickCb)(void)) {
 
-  uint16_t row_p = (GPIO_ReadInputData(KEYS_ROW_PORT)); // read row
-  uint16_t row = ~row_p; // negate, because we use low level for keypress
+  tickCallback = tickCb;
 
-  if (row & KEYS_ROW0_PIN)
-    return 0;
-  if (row & KEYS_ROW1_PIN)
-    return 1;
-  if (row & KEYS_ROW2_PIN)
-    return 2;
-  if (row & KEYS_ROW3_PIN)
-    return 3;
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler = KEYS_TIM_PRESCALER;
+  TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_Period = period - 1;
+  TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(KEYS_TIM, &TIM_TimeBaseStructure);
 
-  return -1;
+  TIM_ClearFlag(KEYS_TIM, TIM_FLAG_Update); // set by TIM_TimeBaseInit
+  TIM_ITConfig(KEYS_TIM, TIM_IT_Update, ENABLE);
+  TIM_Cmd(KEYS_TIM, ENABLE);
 }
+/**
+ * @brief Stops the scan timer.
+ */
+void KEYS_HAL_StopTimer(void) {
+
+  TIM_Cmd(KEYS_TIM, DISABLE);
+  TIM_ITConfig(KEYS_TIM, TIM_IT_Update, DISABLE);
+}
+/**
+ * @brief Blocks the scan timer interrupt.
+ * @details Used by the higher layer when it changes data
+ * shared with the tick callback.
+ */
+void KEYS_HAL_Lock(void) {
+  NVIC_DisableIRQ(KEYS_TIM_IRQ);
+}
+/**
+ * @brief Unblocks the scan timer interrupt.
+ */
+void KEYS_HAL_Unlock(void) {
+  NVIC_EnableIRQ(KEYS_TIM_IRQ);
+}
+/**
+ * @brief IRQ handler for the scan timer.
+ */
+void TIM7_IRQHandler(void) {
+
+  if (TIM_GetITStatus(KEYS_TIM, TIM_IT_Update) != RESET) {
+    TIM_ClearITPendingBit(KEYS_TIM, TIM_IT_Update);
+    if (tickCallback) { // if not NULL
+      tickCallback();
+    }
+  }
+}
+
+#ifdef KEYS_USE_EXTI
+
+/**
+ * @brief Stops scanning and waits for a press.
+ * @details All columns are driven low, so a press on any key
+ * pulls its row low and raises the interrupt. The callback
+ * is called once (from the interrupt) and the lines are masked
+ * again - scanning can start. If a key is already pressed,
+ * the callback is called at once.
+ * @param pressCb Function called when a key is pressed
+ */
+void KEYS_HAL_Idle(void (*pressCb)(void)) {
+
+  pressCallback = pressCb;
+
+  GPIO_ResetBits(KEYS_COL_PORT, KEYS_COL_PINS);
+
+  EXTI_ClearITPendingBit(KEYS_EXTI_LINES);
+  EXTI->IMR |= KEYS_EXTI_LINES;
+
+  // an edge before unmasking would be lost
+  if ((GPIO_ReadInputData(KEYS_ROW_PORT) & KEYS_ROW_PINS) != KEYS_ROW_PINS) {
+    EXTI->IMR &= ~KEYS_EXTI_LINES;
+    if (pressCallback) {
+      pressCallback();
+    }
+  }
+}
+/**
+ * @brief IRQ handler for EXTI lines 10-15 (keyboard rows).
+ */
+void EXTI15_10_IRQHandler(void) {
+
+  if ((EXTI->PR & EXTI->IMR & KEYS_EXTI_LINES) == 0) {
+    return;
+  }
+
+  EXTI->IMR &= ~KEYS_EXTI_LINES; // one wake-up is enough
+  EXTI_ClearITPendingBit(KEYS_EXTI_LINES);
+
+  if (pressCallback) { // if not NULL
+    pressCallback();
+  }
+}
+
+#endif
+
+#ifdef KEYS_USE_DMA
+
+/**
+ * @brief Returns the last rows sampled by DMA for all columns.
+ * @return Pressed keys - bit (column * KEYS_ROWS + row)
+ */
+uint16_t KEYS_HAL_ReadMatrix(void) {
+
+  uint16_t matrix = 0;
+
+  uint8_t col;
+  for (col = 0; col < KEYS_COLUMNS; col++) {
+    // sample k is taken while pattern k-1 is on the port
+    uint16_t sample = rowSamples[(col + 1) % KEYS_COLUMNS];
+    matrix |= KEYS_HAL_Rows(sample) << (col * KEYS_ROWS);
+  }
+
+  return matrix;
+}
+/**
+ * @brief Starts scanning by DMA.
+ */
+static void KEYS_HAL_StartDMA(void) {
+
+  const uint16_t colPins[KEYS_COLUMNS] = {
+    KEYS_COL0_PIN, KEYS_COL1_PIN, KEYS_COL2_PIN, KEYS_COL3_PIN
+  };
+
+  // selected column low (reset half of BSRR), others high
+  uint8_t i;
+  for (i = 0; i < KEYS_COLUMNS; i++) {
+    columnPatterns[i] = ((uint32_t)colPins[i] << 16) | (KEYS_COL_PINS & ~colPins[i]);
+  }
+
+  RCC_AHB1PeriphClockCmd(KEYS_DMA_CLOCK, ENABLE);
+  RCC_APB2PeriphClockCmd(KEYS_DMA_TIM_CLOCK, ENABLE);
+
+  DMA_InitTypeDef DMA_InitStructure;
+
+  // column patterns to BSRR
+  DMA_DeInit(KEYS_DMA_COL);
+  DMA_StructInit(&DMA_InitStructure);
+  DMA_InitStructure.DMA_Channel            = KEYS_DMA_CHANNEL;
+  DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&KEYS_COL_PORT->BSRRL;
+  DMA_InitStructure.DMA_Memory0BaseAddr    = (uint32_t)columnPatterns;
+  DMA_InitStructure.DMA_DIR                = DMA_DIR_MemoryToPeripheral;
+  DMA_InitStructure.DMA_BufferSize         = KEYS_COLUMNS;
+  DMA_InitStructure.DMA_PeripheralInc      = DMA_PeripheralInc_Disable;
+  DMA_InitStructure.DMA_MemoryInc          = DMA_MemoryInc_Enable;
+  DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_Word;
+  DMA_InitStructure.DMA_MemoryDataSize     = DMA_MemoryDataSize_Word;
+  DMA_InitStructure.DMA_Mode               = DMA_Mode_Circular;
+  DMA_InitStructure.DMA_Priority           = DMA_Priority_Low;
+  DMA_Init(KEYS_DMA_COL, &DMA_InitStructure);
+
+  // row port to samples
+  DMA_DeInit(KEYS_DMA_ROW);
+  DMA_InitStructure.DMA_PeripheralBaseAddr = (uint32_t)&KEYS_ROW_PORT->IDR;
+  DMA_InitStructure.DMA_Memory0BaseAddr    = (uint32_t)rowSamples;
+  DMA_InitStructure.DMA_DIR                = DMA_DIR_PeripheralToMemory;
+  DMA_InitStructure.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+  DMA_InitStructure.DMA_MemoryDataSize     = DMA_MemoryDataSize_HalfWord;
+  DMA_Init(KEYS_DMA_ROW, &DMA_InitStructure);
+
+  DMA_Cmd(KEYS_DMA_COL, ENABLE);
+  DMA_Cmd(KEYS_DMA_ROW, ENABLE);
+
+  // the first sample is taken before the first update
+  *(__IO uint32_t*)&KEYS_COL_PORT->BSRRL = columnPatterns[KEYS_COLUMNS - 1];
+
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler = KEYS_DMA_PRESCALER;
+  TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_Period = KEYS_DMA_PERIOD - 1;
+  TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(KEYS_DMA_TIM, &TIM_TimeBaseStructure);
+
+  // compare 1 only times the sampling, no output
+  TIM_OCInitTypeDef TIM_OCInitStructure;
+  TIM_OCStructInit(&TIM_OCInitStructure);
+  TIM_OCInitStructure.TIM_OCMode = TIM_OCMode_Timing;
+  TIM_OCInitStructure.TIM_Pulse  = KEYS_DMA_PERIOD / 2; // lines settled
+  TIM_OC1Init(KEYS_DMA_TIM, &TIM_OCInitStructure);
+
+  TIM_DMACmd(KEYS_DMA_TIM, TIM_DMA_Update | TIM_DMA_CC1, ENABLE);
+  TIM_Cmd(KEYS_DMA_TIM, ENABLE);
+}
+
+#endif
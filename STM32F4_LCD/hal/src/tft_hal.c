@@ -0,0 +1,349 @@
+/**
+ * @file:   tft_hal.c
+ * @brief:  SPI TFT hardware layer
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * The display is on SPI2. SPI runs in full duplex, although
+ * nothing is read, because a received frame tells that the
+ * frame sent with it has left the SPI - then DC can change.
+ * Commands before the pixels are sent byte by byte from the
+ * RXNE interrupt. Pixels are sent by DMA with SPI switched to
+ * 16-bit frames, so RGB565 values go out as they are stored.
+ * A rectangle fill sends one pixel value over and over (memory
+ * increment off). The RX stream counts the frames that left,
+ * its interrupt continues transfers longer than one DMA run
+ * and calls the callback after the last pixel. No interrupt
+ * waits for the SPI.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <tft_hal.h>
+#include <stm32f4xx.h>
+
+#ifdef TFT_ENABLE // see tft_hal.h
+
+#define TFT_SPI         SPI2                  ///< SPI peripheral
+#define TFT_SPI_CLK     RCC_APB1Periph_SPI2   ///< SPI RCC bit
+#define TFT_SPI_AF      GPIO_AF_SPI2          ///< Alternate function
+
+#define TFT_PORT        GPIOB                 ///< TFT GPIO
+#define TFT_PORT_CLK    RCC_AHB1Periph_GPIOB  ///< GPIO RCC bit
+#define TFT_SCK         GPIO_Pin_13           ///< SPI clock
+#define TFT_MOSI        GPIO_Pin_15           ///< SPI data
+#define TFT_SCK_SRC     GPIO_PinSource13      ///< SPI clock pin source
+#define TFT_MOSI_SRC    GPIO_PinSource15      ///< SPI data pin source
+#define TFT_CS          GPIO_Pin_12           ///< Chip select (kept low)
+#define TFT_DC          GPIO_Pin_14           ///< Data (high) or command (low)
+#define TFT_RST         GPIO_Pin_10           ///< Reset
+
+#define TFT_SPI_IRQ     SPI2_IRQn             ///< SPI interrupt
+
+#define TFT_DMA_CLK     RCC_AHB1Periph_DMA1   ///< DMA RCC bit
+#define TFT_DMA_STREAM  DMA1_Stream4          ///< SPI2 TX stream
+#define TFT_DMA_CHANNEL DMA_Channel_0         ///< SPI2 TX channel
+#define TFT_DMA_FLAGS   (DMA_FLAG_TCIF4|DMA_FLAG_HTIF4|DMA_FLAG_TEIF4| \
+    DMA_FLAG_DMEIF4|DMA_FLAG_FEIF4)           ///< All flags of the TX stream
+
+#define TFT_RX_STREAM   DMA1_Stream3          ///< SPI2 RX stream
+#define TFT_RX_CHANNEL  DMA_Channel_0         ///< SPI2 RX channel
+#define TFT_RX_IRQ      DMA1_Stream3_IRQn     ///< RX stream interrupt
+#define TFT_RX_TC       DMA_IT_TCIF3          ///< Transfer complete flag
+#define TFT_RX_FLAGS    (DMA_FLAG_TCIF3|DMA_FLAG_HTIF3|DMA_FLAG_TEIF3| \
+    DMA_FLAG_DMEIF3|DMA_FLAG_FEIF3)           ///< All flags of the RX stream
+
+#define TFT_DMA_MAX     0xffff  ///< Maximum number of items of one DMA run
+#define TFT_RST_DELAY   2000    ///< Delay loop count for reset pulse (min. 10us)
+
+static void (*doneCallback)(void);  ///< Called when pixels are sent
+static DMA_InitTypeDef dmaInit;     ///< DMA settings for pixel transfers
+static DMA_InitTypeDef rxInit;      ///< DMA settings for received frames
+static const uint16_t* dmaPixels;   ///< Next pixels to send
+static uint32_t dmaLeft;            ///< Pixels not yet given to DMA
+static uint16_t rxDummy;            ///< Received frames (discarded)
+
+static const uint8_t* header;       ///< Commands sent before the pixels
+static uint8_t headerLen;           ///< Bytes of the commands
+static uint8_t headerPos;           ///< Next byte of the commands
+static uint8_t paramsLeft;          ///< Parameters left of the current command
+
+static uint8_t TFT_HAL_Exchange(uint8_t byte);
+static void TFT_HAL_SendHeader(void);
+static void TFT_HAL_StartDMA(void);
+
+/**
+ * @brief Initialize SPI, DMA and control pins and reset the display.
+ * @details The display needs 120ms after reset before commands.
+ * @param doneCb Function called (in interrupt) when pixels are sent
+ */
+void TFT_HAL_Init(void (*doneCb)(void)) {
+
+  doneCallback = doneCb;
+
+  GPIO_InitTypeDef  GPIO_InitStructure;
+  SPI_InitTypeDef   SPI_InitStructure;
+
+  // Enable clocks for peripherals
+  RCC_APB1PeriphClockCmd(TFT_SPI_CLK, ENABLE);
+  RCC_AHB1PeriphClockCmd(TFT_PORT_CLK | TFT_DMA_CLK, ENABLE);
+
+  // SCK and MOSI
+  GPIO_InitStructure.GPIO_Pin   = TFT_SCK | TFT_MOSI;
+  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_AF;
+  GPIO_InitStructure.GPIO_Speed = GPIO_Speed_50MHz;
+  GPIO_InitStructure.GPIO_OType = GPIO_OType_PP;
+  GPIO_InitStructure.GPIO_PuPd  = GPIO_PuPd_NOPULL;
+  GPIO_Init(TFT_PORT, &GPIO_InitStructure);
+
+  GPIO_PinAFConfig(TFT_PORT, TFT_SCK_SRC, TFT_SPI_AF);
+  GPIO_PinAFConfig(TFT_PORT, TFT_MOSI_SRC, TFT_SPI_AF);
+
+  // CS, DC and reset
+  GPIO_InitStructure.GPIO_Pin   = TFT_CS | TFT_DC | TFT_RST;
+  GPIO_InitStructure.GPIO_Mode  = GPIO_Mode_OUT;
+  GPIO_Init(TFT_PORT, &GPIO_InitStructure);
+
+  // Only one device on the bus - it stays selected
+  GPIO_ResetBits(TFT_PORT, TFT_CS);
+
+  // Reset pulse
+  GPIO_ResetBits(TFT_PORT, TFT_RST);
+  volatile uint32_t i;
+  for (i = 0; i < TFT_RST_DELAY; i++);
+  GPIO_SetBits(TFT_PORT, TFT_RST);
+
+  // Master, full duplex (see above), mode 0, 21MHz
+  SPI_StructInit(&SPI_InitStructure);
+  SPI_InitStructure.SPI_Direction         = SPI_Direction_2Lines_FullDuplex;
+  SPI_InitStructure.SPI_Mode              = SPI_Mode_Master;
+  SPI_InitStructure.SPI_DataSize          = SPI_DataSize_8b;
+  SPI_InitStructure.SPI_CPOL              = SPI_CPOL_Low;
+  SPI_InitStructure.SPI_CPHA              = SPI_CPHA_1Edge;
+  SPI_InitStructure.SPI_NSS               = SPI_NSS_Soft;
+  SPI_InitStructure.SPI_BaudRatePrescaler = SPI_BaudRatePrescaler_2;
+  SPI_InitStructure.SPI_FirstBit          = SPI_FirstBit_MSB;
+  SPI_Init(TFT_SPI, &SPI_InitStructure);
+  SPI_NSSInternalSoftwareConfig(TFT_SPI, SPI_NSSInternalSoft_Set);
+
+  SPI_Cmd(TFT_SPI, ENABLE);
+
+  // DMA - half words to the SPI data register
+  DMA_StructInit(&dmaInit);
+  dmaInit.DMA_Channel            = TFT_DMA_CHANNEL;
+  dmaInit.DMA_PeripheralBaseAddr = (uint32_t)&TFT_SPI->DR;
+  dmaInit.DMA_DIR                = DMA_DIR_MemoryToPeripheral;
+  dmaInit.DMA_PeripheralInc      = DMA_PeripheralInc_Disable;
+  dmaInit.DMA_PeripheralDataSize = DMA_PeripheralDataSize_HalfWord;
+  dmaInit.DMA_MemoryDataSize     = DMA_MemoryDataSize_HalfWord;
+  dmaInit.DMA_Mode               = DMA_Mode_Normal;
+  dmaInit.DMA_Priority           = DMA_Priority_High;
+
+  // DMA - received frames to one dummy half word
+  DMA_StructInit(&rxInit);
+  rxInit.DMA_Channel             = TFT_RX_CHANNEL;
+  rxInit.DMA_PeripheralBaseAddr  = (uint32_t)&TFT_SPI->DR;
+  rxInit.DMA_Memory0BaseAddr     = (uint32_t)&rxDummy;
+  rxInit.DMA_DIR                 = DMA_DIR_PeripheralToMemory;
+  rxInit.DMA_PeripheralInc       = DMA_PeripheralInc_Disable;
+  rxInit.DMA_MemoryInc           = DMA_MemoryInc_Disable;
+  rxInit.DMA_PeripheralDataSize  = DMA_PeripheralDataSize_HalfWord;
+  rxInit.DMA_MemoryDataSize      = DMA_MemoryDataSize_HalfWord;
+  rxInit.DMA_Mode                = DMA_Mode_Normal;
+  rxInit.DMA_Priority            = DMA_Priority_VeryHigh;
+
+  NVIC_EnableIRQ(TFT_SPI_IRQ);
+  NVIC_EnableIRQ(TFT_RX_IRQ);
+}
+
+/**
+ * @brief Sends a byte and waits until it has left the SPI.
+ * @param byte Byte to send
+ * @return Received byte (meaningless)
+ */
+static uint8_t TFT_HAL_Exchange(uint8_t byte) {
+
+  SPI_I2S_SendData(TFT_SPI, byte);
+  while (SPI_I2S_GetFlagStatus(TFT_SPI, SPI_I2S_FLAG_RXNE) == RESET);
+  return SPI_I2S_ReceiveData(TFT_SPI);
+}
+
+/**
+ * @brief Sends a command with parameters (blocking).
+ * @details Only for the initialization - must not be called
+ * while pixels are being sent.
+ * @param command Command
+ * @param args Parameters
+ * @param len Number of parameters
+ */
+void TFT_HAL_Command(uint8_t command, const uint8_t* args, uint8_t len) {
+
+  GPIO_ResetBits(TFT_PORT, TFT_DC);
+  TFT_HAL_Exchange(command);
+
+  GPIO_SetBits(TFT_PORT, TFT_DC);
+
+  uint8_t i;
+  for (i = 0; i < len; i++) {
+    TFT_HAL_Exchange(args[i]);
+  }
+}
+
+/**
+ * @brief Starts sending commands and then pixels.
+ * @details Returns at once, the callback is called when done.
+ * The commands set the window and start the memory write.
+ * @param commands Commands: command, number of parameters,
+ * parameters, next command... - have to stay valid until done
+ * @param len Number of bytes of the commands (at least one command)
+ * @param pixels Pixels (RGB565) - have to stay valid until done
+ * @param count Number of pixels
+ * @param repeat 0 - send consecutive pixels, 1 - send pixels[0] count times
+ */
+void TFT_HAL_Pixels(const uint8_t* commands, uint8_t len,
+    const uint16_t* pixels, uint32_t count, uint8_t repeat) {
+
+  header     = commands;
+  headerLen  = len;
+  headerPos  = 0;
+  paramsLeft = 0;
+
+  dmaPixels = pixels;
+  dmaLeft = count;
+  dmaInit.DMA_MemoryInc = repeat ? DMA_MemoryInc_Disable : DMA_MemoryInc_Enable;
+
+  // first byte, the rest follows in the interrupt
+  TFT_HAL_SendHeader();
+  SPI_I2S_ITConfig(TFT_SPI, SPI_I2S_IT_RXNE, ENABLE);
+}
+
+/**
+ * @brief Blocks the end of transfer interrupt.
+ * @details Used by the higher layer when it changes data
+ * shared with the callback.
+ */
+void TFT_HAL_Lock(void) {
+  NVIC_DisableIRQ(TFT_RX_IRQ);
+}
+/**
+ * @brief Unblocks the end of transfer interrupt.
+ */
+void TFT_HAL_Unlock(void) {
+  NVIC_EnableIRQ(TFT_RX_IRQ);
+}
+
+/**
+ * @brief Sends the next byte of the commands.
+ * @details Called when the previous byte has left the SPI,
+ * so DC can be changed.
+ */
+static void TFT_HAL_SendHeader(void) {
+
+  uint8_t byte;
+
+  if (paramsLeft) {
+    GPIO_SetBits(TFT_PORT, TFT_DC);
+    byte = header[headerPos++];
+    paramsLeft--;
+  } else {
+    GPIO_ResetBits(TFT_PORT, TFT_DC);
+    byte = header[headerPos++];
+    paramsLeft = header[headerPos++];
+  }
+
+  SPI_I2S_SendData(TFT_SPI, byte);
+}
+
+/**
+ * @brief Gives the next part of the pixels to DMA.
+ * @details The RX stream gets the same number of frames, its
+ * end means the last pixel has left the SPI.
+ */
+static void TFT_HAL_StartDMA(void) {
+
+  uint32_t count = dmaLeft > TFT_DMA_MAX ? TFT_DMA_MAX : dmaLeft;
+
+  DMA_DeInit(TFT_RX_STREAM);
+  rxInit.DMA_BufferSize = count;
+  DMA_Init(TFT_RX_STREAM, &rxInit);
+  DMA_ClearFlag(TFT_RX_STREAM, TFT_RX_FLAGS);
+  DMA_ITConfig(TFT_RX_STREAM, DMA_IT_TC, ENABLE);
+
+  DMA_DeInit(TFT_DMA_STREAM);
+  dmaInit.DMA_Memory0BaseAddr = (uint32_t)dmaPixels;
+  dmaInit.DMA_BufferSize      = count;
+  DMA_Init(TFT_DMA_STREAM, &dmaInit);
+  DMA_ClearFlag(TFT_DMA_STREAM, TFT_DMA_FLAGS);
+
+  dmaLeft -= count;
+  if (dmaInit.DMA_MemoryInc == DMA_MemoryInc_Enable) {
+    dmaPixels += count;
+  }
+
+  DMA_Cmd(TFT_RX_STREAM, ENABLE);
+  DMA_Cmd(TFT_DMA_STREAM, ENABLE);
+}
+
+/**
+ * @brief IRQ handler for SPI2.
+ * @details A byte of the commands has left the SPI - sends
+ * the next one or starts the pixels.
+ */
+void SPI2_IRQHandler(void) {
+
+  if (SPI_I2S_GetITStatus(TFT_SPI, SPI_I2S_IT_RXNE) == RESET) {
+    return;
+  }
+  SPI_I2S_ReceiveData(TFT_SPI); // clears RXNE
+
+  if (headerPos < headerLen) {
+    TFT_HAL_SendHeader();
+    return;
+  }
+
+  SPI_I2S_ITConfig(TFT_SPI, SPI_I2S_IT_RXNE, DISABLE);
+
+  // 16-bit frames - pixels go out high byte first
+  GPIO_SetBits(TFT_PORT, TFT_DC);
+  SPI_Cmd(TFT_SPI, DISABLE);
+  SPI_DataSizeConfig(TFT_SPI, SPI_DataSize_16b);
+  SPI_I2S_DMACmd(TFT_SPI, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, ENABLE);
+  TFT_HAL_StartDMA();
+  SPI_Cmd(TFT_SPI, ENABLE);
+}
+
+/**
+ * @brief IRQ handler for the SPI2 RX DMA stream.
+ */
+void DMA1_Stream3_IRQHandler(void) {
+
+  if (DMA_GetITStatus(TFT_RX_STREAM, TFT_RX_TC) == RESET) {
+    return;
+  }
+  DMA_ClearITPendingBit(TFT_RX_STREAM, TFT_RX_TC);
+
+  if (dmaLeft) {
+    TFT_HAL_StartDMA();
+    return;
+  }
+
+  // last pixel has left the SPI - back to 8-bit frames
+  SPI_Cmd(TFT_SPI, DISABLE);
+  SPI_I2S_DMACmd(TFT_SPI, SPI_I2S_DMAReq_Rx | SPI_I2S_DMAReq_Tx, DISABLE);
+  SPI_DataSizeConfig(TFT_SPI, SPI_DataSize_8b);
+  SPI_Cmd(TFT_SPI, ENABLE);
+
+  if (doneCallback) { // if not NULL
+    doneCallback();
+  }
+}
+
+#endif /* TFT_ENABLE */
@@ -0,0 +1,52 @@
+/**
+ * @file: 	timer5.c
+ * @brief:	Free running microsecond counter
+ * @date: 	18 paź 2026
+ * @author: agent
+ * 
+ * TIM5 is a 32-bit timer - clocked at 1 MHz it counts
+ * microseconds by itself, without any interrupts, and
+ * wraps around every ~71 minutes.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the 
+ * accompanying materials are made available 
+ * under the terms of the GNU Public License 
+ * v3.0 which accompanies this distribution, 
+ * and is available at 
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <stm32f4xx.h>
+#include <timer5.h>
+
+#define TIMER5_PRESCALER 83 ///< 84 MHz APB1 timer clock / (83+1) = 1 MHz
+
+/**
+ * @brief Initialize timer5 as microsecond counter
+ */
+void TIMER5_Init(void) {
+
+  RCC_APB1PeriphClockCmd(RCC_APB1Periph_TIM5, ENABLE);
+
+  TIM_TimeBaseInitTypeDef TIM_TimeBaseStructure;
+  TIM_TimeBaseStructure.TIM_Prescaler = TIMER5_PRESCALER;
+  TIM_TimeBaseStructure.TIM_CounterMode = TIM_CounterMode_Up;
+  TIM_TimeBaseStructure.TIM_Period = 0xffffffff; // use the full 32 bits
+  TIM_TimeBaseStructure.TIM_ClockDivision = 0;
+  TIM_TimeBaseStructure.TIM_RepetitionCounter = 0;
+  TIM_TimeBaseInit(TIM5, &TIM_TimeBaseStructure); // generates update - prescaler loaded now
+
+  TIM_Cmd(TIM5, ENABLE); // enable timer
+}
+/**
+ * @brief Get time value
+ * @return Time in microseconds
+ */
+uint32_t TIMER5_GetTime(void) {
+
+  return TIM5->CNT;
+
+}
@@ -0,0 +1,63 @@
+/**
+ * @file:   hd44780_sim.h
+ * @brief:  Simulated HD44780 for host builds
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * The simulator replaces hd44780_hal.c, systick.c and timer5.c,
+ * so the LCD driver can be run and measured on a PC. "make test"
+ * in the sim directory runs the regression tests (lcd_test.c) and
+ * "make bench" the comparison of driver configurations (lcd_bench.c).
+ *
+ * Compile with the same LCD_WRITE_ONLY/LCD_8BIT settings as the driver.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef HD44780_SIM_H_
+#define HD44780_SIM_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  LCD_SIM LCD_SIM
+ * @brief     Simulated HD44780 for host builds
+ */
+
+/**
+ * @addtogroup LCD_SIM
+ * @{
+ */
+
+/**
+ * @brief Bus statistics (all displays).
+ */
+typedef struct {
+  uint32_t commands;    ///< Instructions executed
+  uint32_t data;        ///< Data bytes written
+  uint32_t reads;       ///< Busy flag reads
+  uint32_t cycles;      ///< E strobes
+  uint32_t violations;  ///< Transfers ignored because the controller was busy
+  uint64_t busTime;     ///< Time spent on E cycles in ns
+} LCD_SIM_Stats_TypeDef;
+
+void            LCD_SIM_Reset     (void);
+void            LCD_SIM_GetStats  (LCD_SIM_Stats_TypeDef* stats);
+void            LCD_SIM_GetScreen (uint8_t display, uint8_t columns, uint8_t rows,
+    uint8_t* screen);
+const uint8_t*  LCD_SIM_GetCGRAM  (uint8_t display);
+void            LCD_SIM_Print     (uint8_t display, uint8_t columns, uint8_t rows);
+
+/**
+ * @}
+ */
+
+#endif /* HD44780_SIM_H_ */
@@ -0,0 +1,41 @@
+/**
+ * @file:   sim_clock.h
+ * @brief:  Simulated time base for host builds
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#ifndef SIM_CLOCK_H_
+#define SIM_CLOCK_H_
+
+#include <inttypes.h>
+
+/**
+ * @defgroup  SIM_CLOCK SIM_CLOCK
+ * @brief     Simulated time base for host builds
+ */
+
+/**
+ * @addtogroup SIM_CLOCK
+ * @{
+ */
+
+void      SIM_CLOCK_Reset   (void);
+void      SIM_CLOCK_Advance (uint32_t ns);
+uint64_t  SIM_CLOCK_GetTime (void);
+
+/**
+ * @}
+ */
+
+#endif /* SIM_CLOCK_H_ */
@@ -0,0 +1,128 @@
+/**
+ * @file:   gfx_bench.c
+ * @brief:  Throughput of the software graphics renderer
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Runs every drawing function of gfx.c on a 240x320 framebuffer
+ * and prints the rendering speed in Mpixel/s, so changes to the
+ * software renderer can be measured on a PC ("make bench"
+ * in the sim directory).
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <gfx.h>
+#include <font.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define BENCH_WIDTH   240   ///< Framebuffer width
+#define BENCH_HEIGHT  320   ///< Framebuffer height
+#define BENCH_TIME    0.5   ///< Minimum run time of one test in s
+#define BENCH_BITMAP  64    ///< Bitmap side
+
+static uint16_t frame[BENCH_WIDTH * BENCH_HEIGHT];  ///< Framebuffer
+static uint16_t bitmap[BENCH_BITMAP * BENCH_BITMAP]; ///< Test bitmap
+
+/**
+ * @brief Returns the host time.
+ * @return Time in s
+ */
+static double BENCH_Now(void) {
+
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+/**
+ * @brief Tests one drawing function.
+ * @param name Name of the test
+ * @param draw Draws a frame, returns the number of pixels drawn
+ */
+static void BENCH_Run(const char* name, uint32_t (*draw)(uint32_t)) {
+
+  uint64_t pixels = 0;
+  uint32_t n = 0;
+  double start = BENCH_Now();
+  double elapsed;
+
+  do {
+    pixels += draw(n++);
+    elapsed = BENCH_Now() - start;
+  } while (elapsed < BENCH_TIME);
+
+  printf("%-16s %8.1f Mpixel/s\r\n", name, pixels / elapsed * 1e-6);
+}
+
+/**
+ * @brief Whole screen fill.
+ */
+static uint32_t BENCH_Clear(uint32_t n) {
+  GFX_FillRect(0, 0, BENCH_WIDTH, BENCH_HEIGHT, (uint16_t)n);
+  return BENCH_WIDTH * BENCH_HEIGHT;
+}
+/**
+ * @brief Fill of a rectangle at an odd column.
+ */
+static uint32_t BENCH_Fill(uint32_t n) {
+  GFX_FillRect(1 + n % 2, 10, 101, 100, (uint16_t)n);
+  return 101 * 100;
+}
+/**
+ * @brief Bitmap copy.
+ */
+static uint32_t BENCH_Blit(uint32_t n) {
+  GFX_Blit(n % 100, 20, BENCH_BITMAP, BENCH_BITMAP, bitmap);
+  return BENCH_BITMAP * BENCH_BITMAP;
+}
+/**
+ * @brief Half transparent bitmap.
+ */
+static uint32_t BENCH_Blend(uint32_t n) {
+  GFX_Blend(n % 100, 20, BENCH_BITMAP, BENCH_BITMAP, bitmap, 128);
+  return BENCH_BITMAP * BENCH_BITMAP;
+}
+/**
+ * @brief Screen of text.
+ */
+static uint32_t BENCH_Text(uint32_t n) {
+
+  const char* s = n & 1 ? "The quick brown fox jumps over" :
+      "THE LAZY DOG 0123456789 !?#$%&";
+  uint32_t chars = 0;
+  uint16_t y;
+
+  for (y = 0; y + FONT_CELL_HEIGHT <= BENCH_HEIGHT; y += FONT_CELL_HEIGHT) {
+    GFX_DrawString(0, y, s, 0xffff, 0x0000);
+    chars += strlen(s); // all fit in the row
+  }
+  return chars * FONT_CELL_WIDTH * FONT_CELL_HEIGHT;
+}
+
+int main(void) {
+
+  uint32_t i;
+  for (i = 0; i < BENCH_BITMAP * BENCH_BITMAP; i++) {
+    bitmap[i] = (uint16_t)(i * 2654435761u >> 16);
+  }
+
+  GFX_Init(frame, BENCH_WIDTH, BENCH_HEIGHT);
+
+  BENCH_Run("clear", BENCH_Clear);
+  BENCH_Run("fill", BENCH_Fill);
+  BENCH_Run("blit", BENCH_Blit);
+  BENCH_Run("blend", BENCH_Blend);
+  BENCH_Run("text", BENCH_Text);
+
+  return 0;
+}
@@ -0,0 +1,395 @@
+/**
+ * @file:   hd44780_sim.c
+ * @brief:  Simulated HD44780 for host builds
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Implements hd44780_hal.h on top of a model of the controller:
+ * DDRAM, CGRAM, address counter, entry mode, display shift,
+ * 4/8-bit interface and the busy time of every instruction.
+ * Every E cycle moves the simulated clock (see sim_clock.c).
+ * A transfer made while the controller is busy is ignored
+ * (as by the real chip) and counted as a violation.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <hd44780_sim.h>
+#include <hd44780_hal.h>
+#include <sim_clock.h>
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * @addtogroup LCD_SIM
+ * @{
+ */
+
+/*
+ * Timing of the simulated controller in ns. Defaults are
+ * datasheet values for fosc = 270kHz - define longer times
+ * to check the driver against a slow controller.
+ */
+#ifndef LCD_SIM_CYCLE_TIME
+  #define LCD_SIM_CYCLE_TIME    1000    ///< E cycle time
+#endif
+#ifndef LCD_SIM_EXEC_SHORT
+  #define LCD_SIM_EXEC_SHORT    37000   ///< Execution time of most instructions
+#endif
+#ifndef LCD_SIM_EXEC_DATA
+  #define LCD_SIM_EXEC_DATA     41000   ///< Execution time of a RAM write
+#endif
+#ifndef LCD_SIM_EXEC_LONG
+  #define LCD_SIM_EXEC_LONG     1520000 ///< Execution time of clear and home
+#endif
+#ifndef LCD_SIM_POWER_ON
+  #define LCD_SIM_POWER_ON      40000000 ///< Time after power on when the controller is busy
+#endif
+
+#define LCD_SIM_DISPLAYS  4     ///< Number of E lines
+#define LCD_SIM_LINE      40    ///< Length of a line in 2-line mode
+#define LCD_SIM_DDRAM     80    ///< Size of DDRAM
+
+/**
+ * @brief State of one simulated controller.
+ */
+typedef struct {
+  uint8_t ddram[0x80];  ///< DDRAM (indexed by address)
+  uint8_t cgram[64];    ///< CGRAM
+  uint8_t ac;           ///< Address counter
+  uint8_t cgMode;       ///< AC points to CGRAM?
+  uint8_t increment;    ///< Entry mode I/D
+  uint8_t autoShift;    ///< Entry mode S
+  uint8_t displayOn;    ///< Display on/off
+  uint8_t bus8;         ///< 8-bit interface (DL)
+  uint8_t lines2;       ///< 2-line mode (N)
+  int8_t  shift;        ///< Display shift (left shifts count up)
+  uint8_t nibble;       ///< High nibble of a 4-bit transfer
+  uint8_t haveNibble;   ///< High nibble already received?
+  uint64_t busyUntil;   ///< End of current instruction in ns
+} LCD_SIM_TypeDef;
+
+static LCD_SIM_TypeDef sims[LCD_SIM_DISPLAYS]; ///< Simulated controllers
+static LCD_SIM_TypeDef* sim = &sims[0];        ///< Selected controller
+static LCD_SIM_Stats_TypeDef stats;            ///< Bus statistics
+
+static void LCD_SIM_Transfer(uint8_t lines, uint8_t rs);
+static void LCD_SIM_Execute(uint8_t byte, uint8_t rs);
+static void LCD_SIM_MoveAC(int8_t dir);
+static void LCD_SIM_Shift(int8_t dir);
+
+/**
+ * @brief Power on of all controllers.
+ * @details Controllers start in 8-bit, 1-line mode with display
+ * off and are busy for LCD_SIM_POWER_ON. Clock is set to zero.
+ */
+void LCD_SIM_Reset(void) {
+
+  uint8_t i;
+
+  SIM_CLOCK_Reset();
+  memset(sims, 0, sizeof(sims));
+  memset(&stats, 0, sizeof(stats));
+
+  for (i = 0; i < LCD_SIM_DISPLAYS; i++) {
+    memset(sims[i].ddram, ' ', sizeof(sims[i].ddram));
+    sims[i].increment = 1;
+    sims[i].bus8 = 1;
+    sims[i].busyUntil = LCD_SIM_POWER_ON;
+  }
+  sim = &sims[0];
+}
+/**
+ * @brief Returns bus statistics.
+ * @param s Statistics
+ */
+void LCD_SIM_GetStats(LCD_SIM_Stats_TypeDef* s) {
+  *s = stats;
+}
+/**
+ * @brief Returns what is shown on a display.
+ * @details Rows 3 and 4 of 4 row displays continue rows 1 and 2
+ * in DDRAM. Nothing is shown while the display is off.
+ * @param display Display number
+ * @param columns Number of columns of the module
+ * @param rows Number of rows of the module
+ * @param screen Buffer for columns*rows character codes (row by row)
+ */
+void LCD_SIM_GetScreen(uint8_t display, uint8_t columns, uint8_t rows,
+    uint8_t* screen) {
+
+  LCD_SIM_TypeDef* s = &sims[display % LCD_SIM_DISPLAYS];
+  uint8_t x, y;
+
+  for (y = 0; y < rows; y++) {
+    for (x = 0; x < columns; x++) {
+
+      uint8_t address;
+
+      if (s->lines2) {
+        uint8_t offset = (x + (y / 2) * columns + s->shift + 2*LCD_SIM_LINE) % LCD_SIM_LINE;
+        address = (y % 2) * 0x40 + offset;
+      } else {
+        address = (x + y * columns + s->shift + 2*LCD_SIM_DDRAM) % LCD_SIM_DDRAM;
+      }
+
+      *screen++ = s->displayOn ? s->ddram[address] : ' ';
+    }
+  }
+}
+/**
+ * @brief Returns CGRAM of a display.
+ * @param display Display number
+ * @return 64 bytes of CGRAM
+ */
+const uint8_t* LCD_SIM_GetCGRAM(uint8_t display) {
+  return sims[display % LCD_SIM_DISPLAYS].cgram;
+}
+/**
+ * @brief Prints the screen of a display to stdout.
+ * @details CGRAM characters are shown as their code (0 - 7),
+ * characters outside ASCII as '#'.
+ * @param display Display number
+ * @param columns Number of columns of the module
+ * @param rows Number of rows of the module
+ */
+void LCD_SIM_Print(uint8_t display, uint8_t columns, uint8_t rows) {
+
+  uint8_t screen[LCD_SIM_DDRAM];
+  uint8_t x, y;
+
+  if (columns * rows > LCD_SIM_DDRAM) {
+    return;
+  }
+
+  LCD_SIM_GetScreen(display, columns, rows, screen);
+
+  for (y = 0; y < rows; y++) {
+    putchar('|');
+    for (x = 0; x < columns; x++) {
+      uint8_t c = screen[y * columns + x];
+      if (c < 0x10) {
+        putchar('0' + (c & 0x07));
+      } else if (c < 0x20 || c > 0x7e) {
+        putchar('#');
+      } else {
+        putchar(c);
+      }
+    }
+    printf("|\n");
+  }
+}
+/**
+ * @brief Simulated HAL initialization.
+ */
+void LCD_HAL_Init(void) {
+}
+/**
+ * @brief Selects the E line.
+ * @param display Display number
+ */
+void LCD_HAL_Select(uint8_t display) {
+  sim = &sims[display % LCD_SIM_DISPLAYS];
+}
+/**
+ * @brief Writes a nibble on D7..D4 (D3..D0 low).
+ * @param nibble Data in lower 4 bits
+ * @param rs Register select: 0 - command, 1 - data
+ */
+void LCD_HAL_WriteNibble(uint8_t nibble, uint8_t rs) {
+  LCD_SIM_Transfer((nibble & 0x0f) << 4, rs);
+}
+/**
+ * @brief Sends a byte.
+ * @param data Data or command
+ * @param rs Register select: 0 - command, 1 - data
+ */
+void LCD_HAL_Send(uint8_t data, uint8_t rs) {
+#ifdef LCD_8BIT
+  LCD_SIM_Transfer(data, rs);
+#else
+  LCD_SIM_Transfer(data & 0xf0, rs);
+  LCD_SIM_Transfer(data << 4, rs);
+#endif
+}
+
+#ifndef LCD_WRITE_ONLY
+/**
+ * @brief Reads the busy flag and address counter.
+ * @return Status byte
+ */
+uint8_t LCD_HAL_ReadStatus(void) {
+
+#ifdef LCD_8BIT
+  uint8_t cycles = 1;
+#else
+  uint8_t cycles = 2;
+#endif
+
+  stats.reads++;
+  stats.cycles += cycles;
+  stats.busTime += cycles * LCD_SIM_CYCLE_TIME;
+  SIM_CLOCK_Advance(cycles * LCD_SIM_CYCLE_TIME);
+
+  uint8_t busy = SIM_CLOCK_GetTime() < sim->busyUntil;
+
+  return (busy ? 0x80 : 0) | (sim->ac & 0x7f);
+}
+#else
+/**
+ * @brief Returns the number of transfers waiting to be sent.
+ * @return Always 0 - transfers are made at once
+ */
+uint8_t LCD_HAL_Queued(void) {
+  return 0;
+}
+#endif
+
+/**
+ * @brief One E cycle of a write.
+ * @param lines State of D7..D0
+ * @param rs Register select
+ */
+static void LCD_SIM_Transfer(uint8_t lines, uint8_t rs) {
+
+  stats.cycles++;
+  stats.busTime += LCD_SIM_CYCLE_TIME;
+  SIM_CLOCK_Advance(LCD_SIM_CYCLE_TIME);
+
+  if (SIM_CLOCK_GetTime() < sim->busyUntil) {
+    stats.violations++;
+    return;
+  }
+
+  if (sim->bus8) {
+    LCD_SIM_Execute(lines, rs);
+  } else if (!sim->haveNibble) {
+    sim->nibble = lines & 0xf0;
+    sim->haveNibble = 1;
+  } else {
+    sim->haveNibble = 0;
+    LCD_SIM_Execute(sim->nibble | (lines >> 4), rs);
+  }
+}
+/**
+ * @brief Executes an instruction or a RAM write.
+ * @param byte Instruction or data
+ * @param rs Register select
+ */
+static void LCD_SIM_Execute(uint8_t byte, uint8_t rs) {
+
+  uint32_t time = LCD_SIM_EXEC_SHORT;
+
+  if (rs) {
+    stats.data++;
+    if (sim->cgMode) {
+      sim->cgram[sim->ac & 0x3f] = byte & 0x1f;
+    } else {
+      sim->ddram[sim->ac & 0x7f] = byte;
+    }
+    LCD_SIM_MoveAC(sim->increment ? 1 : -1);
+    if (sim->autoShift && !sim->cgMode) {
+      LCD_SIM_Shift(sim->increment ? 1 : -1);
+    }
+    time = LCD_SIM_EXEC_DATA;
+
+  } else {
+    stats.commands++;
+
+    if (byte & 0x80) {          // set DDRAM address
+      sim->cgMode = 0;
+      sim->ac = byte & 0x7f;
+    } else if (byte & 0x40) {   // set CGRAM address
+      sim->cgMode = 1;
+      sim->ac = byte & 0x3f;
+    } else if (byte & 0x20) {   // function set
+      sim->bus8 = (byte & 0x10) ? 1 : 0;
+      sim->lines2 = (byte & 0x08) ? 1 : 0;
+      sim->haveNibble = 0;
+    } else if (byte & 0x10) {   // cursor or display shift
+      int8_t dir = (byte & 0x04) ? -1 : 1;
+      if (byte & 0x08) {
+        LCD_SIM_Shift(dir);
+      } else {
+        LCD_SIM_MoveAC(-dir);
+      }
+    } else if (byte & 0x08) {   // display on/off
+      sim->displayOn = (byte & 0x04) ? 1 : 0;
+    } else if (byte & 0x04) {   // entry mode
+      sim->increment = (byte & 0x02) ? 1 : 0;
+      sim->autoShift = (byte & 0x01) ? 1 : 0;
+    } else if (byte & 0x02) {   // home
+      sim->cgMode = 0;
+      sim->ac = 0;
+      sim->shift = 0;
+      time = LCD_SIM_EXEC_LONG;
+    } else if (byte & 0x01) {   // clear
+      memset(sim->ddram, ' ', sizeof(sim->ddram));
+      sim->cgMode = 0;
+      sim->ac = 0;
+      sim->shift = 0;
+      sim->increment = 1;
+      time = LCD_SIM_EXEC_LONG;
+    }
+  }
+
+  sim->busyUntil = SIM_CLOCK_GetTime() + time;
+}
+/**
+ * @brief Moves the address counter by one.
+ * @details DDRAM addresses wrap like in the controller:
+ * 0x27 <-> 0x40 and 0x67 <-> 0x00 in 2-line mode.
+ * @param dir 1 - increment, -1 - decrement
+ */
+static void LCD_SIM_MoveAC(int8_t dir) {
+
+  if (sim->cgMode) {
+    sim->ac = (sim->ac + dir) & 0x3f;
+    return;
+  }
+
+  if (!sim->lines2) {
+    sim->ac = (sim->ac + LCD_SIM_DDRAM + dir) % LCD_SIM_DDRAM;
+    return;
+  }
+
+  if (dir > 0) {
+    if (sim->ac == 0x27) {
+      sim->ac = 0x40;
+    } else if (sim->ac == 0x67) {
+      sim->ac = 0x00;
+    } else {
+      sim->ac++;
+    }
+  } else {
+    if (sim->ac == 0x40) {
+      sim->ac = 0x27;
+    } else if (sim->ac == 0x00) {
+      sim->ac = 0x67;
+    } else {
+      sim->ac--;
+    }
+  }
+}
+/**
+ * @brief Shifts the display by one character.
+ * @param dir 1 - left, -1 - right
+ */
+static void LCD_SIM_Shift(int8_t dir) {
+
+  int8_t len = sim->lines2 ? LCD_SIM_LINE : LCD_SIM_DDRAM;
+
+  sim->shift = (sim->shift + dir + len) % len;
+}
+
+/**
+ * @}
+ */
@@ -0,0 +1,235 @@
+/**
+ * @file:   lcd_bench.c
+ * @brief:  Comparison of HD44780 driver configurations on the simulator
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Measures the driver built with the current configuration
+ * (LCD_WRITE_ONLY, LCD_8BIT, LCD_ASYNC_INIT) on a simulated
+ * 20x4 display and prints one row of the comparison table.
+ * "make bench" in the sim directory builds every configuration
+ * and prints the whole table (run with -h for the header).
+ *
+ * CPU time is the time spent inside LCD_Init and LCD_Update
+ * (bus cycles and busy flag polling) - the main loop gets
+ * the rest of the time.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <hd44780.h>
+#include <hd44780_sim.h>
+#include <sim_clock.h>
+#include <timers.h>
+#include <stdio.h>
+#include <string.h>
+
+#define BENCH_LOOP_TIME 1000  ///< Time of one main loop pass outside the driver in ns
+#define BENCH_TIMEOUT   1000  ///< Maximum time of one measurement in ms
+#define BENCH_COLUMNS   20    ///< Columns of the display
+#define BENCH_ROWS      4     ///< Rows of the display
+#define BENCH_FIELDS    100   ///< Number of field updates measured
+
+/**
+ * @brief Result of one measurement.
+ */
+typedef struct {
+  uint64_t time;    ///< Time until the screen was right in ns
+  uint64_t cpu;     ///< Time spent in the driver in ns
+  uint32_t cycles;  ///< E cycles
+  uint32_t reads;   ///< Busy flag reads
+} BENCH_Result_TypeDef;
+
+static uint64_t cpuTime; ///< Time spent in the driver in ns
+
+/**
+ * @brief Returns the name of the configuration.
+ */
+static const char* BENCH_Name(void) {
+
+  static char name[48];
+
+  name[0] = '\0';
+#ifdef LCD_8BIT
+  strcat(name, "8bit ");
+#else
+  strcat(name, "4bit ");
+#endif
+#ifdef LCD_WRITE_ONLY
+  strcat(name, "write-only ");
+#else
+  strcat(name, "busy-flag ");
+#endif
+#ifdef LCD_ASYNC_INIT
+  strcat(name, "async-init");
+#endif
+  return name;
+}
+/**
+ * @brief One pass of the main loop.
+ */
+static void BENCH_Loop(void) {
+
+  uint64_t start = SIM_CLOCK_GetTime();
+  LCD_Update();
+  cpuTime += SIM_CLOCK_GetTime() - start;
+
+  SIM_CLOCK_Advance(BENCH_LOOP_TIME);
+}
+/**
+ * @brief Runs the main loop until the screen shows the text.
+ * @param expected Expected characters, row after row
+ * @param start Statistics at the start of the measurement
+ * @param startTime Time at the start of the measurement
+ * @param result Result
+ */
+static void BENCH_Wait(const char* expected, const LCD_SIM_Stats_TypeDef* start,
+    uint64_t startTime, BENCH_Result_TypeDef* result) {
+
+  uint8_t screen[BENCH_COLUMNS * BENCH_ROWS];
+  LCD_SIM_Stats_TypeDef stats;
+  uint64_t end = startTime + BENCH_TIMEOUT * 1000000ULL;
+
+  while (SIM_CLOCK_GetTime() < end) {
+    LCD_SIM_GetScreen(0, BENCH_COLUMNS, BENCH_ROWS, screen);
+    if (!memcmp(screen, expected, sizeof(screen))) {
+      break;
+    }
+    BENCH_Loop();
+  }
+
+  LCD_SIM_GetStats(&stats);
+  result->time   = SIM_CLOCK_GetTime() - startTime;
+  result->cpu    = cpuTime;
+  result->cycles = stats.cycles - start->cycles;
+  result->reads  = stats.reads - start->reads;
+}
+/**
+ * @brief Measures the time to a usable display.
+ * @param result Result
+ */
+static void BENCH_Init(BENCH_Result_TypeDef* result) {
+
+  char expected[BENCH_COLUMNS * BENCH_ROWS];
+  LCD_SIM_Stats_TypeDef stats;
+
+  LCD_SIM_Reset();
+  LCD_SIM_GetStats(&stats);
+  cpuTime = 0;
+
+  uint64_t start = SIM_CLOCK_GetTime();
+  LCD_Init(LCD_20x4);
+  cpuTime += SIM_CLOCK_GetTime() - start;
+
+  LCD_Putc('*'); // shown when the display is ready
+  memset(expected, ' ', sizeof(expected));
+  expected[0] = '*';
+
+  BENCH_Wait(expected, &stats, start, result);
+}
+/**
+ * @brief Measures writing the whole screen.
+ * @param result Result
+ */
+static void BENCH_Screen(BENCH_Result_TypeDef* result) {
+
+  char expected[BENCH_COLUMNS * BENCH_ROWS];
+  LCD_SIM_Stats_TypeDef stats;
+  uint8_t i;
+
+  for (i = 0; i < sizeof(expected); i++) {
+    expected[i] = 'A' + i % 26;
+  }
+
+  LCD_SIM_GetStats(&stats);
+  cpuTime = 0;
+  uint64_t start = SIM_CLOCK_GetTime();
+
+  for (i = 0; i < BENCH_ROWS; i++) {
+    LCD_Write(0, i, &expected[i * BENCH_COLUMNS], BENCH_COLUMNS);
+  }
+
+  BENCH_Wait(expected, &stats, start, result);
+}
+/**
+ * @brief Measures updates of a 5 digit number (average).
+ * @param result Result
+ */
+static void BENCH_Field(BENCH_Result_TypeDef* result) {
+
+  char expected[BENCH_COLUMNS * BENCH_ROWS + 1];
+  BENCH_Result_TypeDef one;
+  LCD_SIM_Stats_TypeDef stats;
+  uint8_t screen[BENCH_COLUMNS * BENCH_ROWS];
+  uint32_t i;
+
+  memset(result, 0, sizeof(*result));
+  LCD_SIM_GetScreen(0, BENCH_COLUMNS, BENCH_ROWS, screen);
+  memcpy(expected, screen, sizeof(screen));
+
+  for (i = 0; i < BENCH_FIELDS; i++) {
+
+    int32_t value = 12345 + i * 7;
+    char digits[6];
+    snprintf(digits, sizeof(digits), "%5d", (int)value);
+    memcpy(&expected[BENCH_COLUMNS + 10], digits, 5);
+
+    LCD_SIM_GetStats(&stats);
+    cpuTime = 0;
+    uint64_t start = SIM_CLOCK_GetTime();
+
+    LCD_PutInt(10, 1, 5, value);
+    BENCH_Wait(expected, &stats, start, &one);
+
+    result->time   += one.time;
+    result->cpu    += one.cpu;
+    result->cycles += one.cycles;
+    result->reads  += one.reads;
+  }
+
+  result->time   /= BENCH_FIELDS;
+  result->cpu    /= BENCH_FIELDS;
+  result->cycles /= BENCH_FIELDS;
+  result->reads  /= BENCH_FIELDS;
+}
+
+int main(int argc, char** argv) {
+
+  BENCH_Result_TypeDef init, screen, field;
+  LCD_SIM_Stats_TypeDef stats;
+
+  if (argc > 1 && !strcmp(argv[1], "-h")) {
+    printf("%-28s %9s %9s | %9s %9s %7s %6s | %9s %9s %6s\n",
+        "configuration", "init ms", "cpu ms",
+        "screen us", "cpu us", "cycles", "reads",
+        "field us", "cpu us", "cycles");
+    return 0;
+  }
+
+  TIMER_Init(1000);
+
+  BENCH_Init(&init);
+  BENCH_Screen(&screen);
+  BENCH_Field(&field);
+
+  printf("%-28s %9.2f %9.2f | %9.1f %9.1f %7u %6u | %9.1f %9.1f %6u\n",
+      BENCH_Name(), init.time * 1e-6, init.cpu * 1e-6,
+      screen.time * 1e-3, screen.cpu * 1e-3, (unsigned)screen.cycles,
+      (unsigned)screen.reads, field.time * 1e-3, field.cpu * 1e-3,
+      (unsigned)field.cycles);
+
+  LCD_SIM_GetStats(&stats);
+  if (stats.violations) {
+    printf("%u transfers while busy!\n", (unsigned)stats.violations);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,359 @@
+/**
+ * @file:   lcd_test.c
+ * @brief:  Regression tests of the HD44780 driver on the simulator
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Runs the driver against the simulated controller and checks
+ * what ends up on the screen and that no transfer was made
+ * while the controller was busy. Build and run it for every
+ * driver configuration with "make test" in the sim directory.
+ * Returns 0 if all checks passed.
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <hd44780.h>
+#include <hd44780_sim.h>
+#include <sim_clock.h>
+#include <timers.h>
+#include <stdio.h>
+#include <string.h>
+
+#define TEST_FLUSH_TIME 100   ///< Time given to the driver to empty its queue in ms
+#define TEST_LOOP_TIME  1000  ///< Time of one main loop pass in ns
+#define TEST_MAX_CHARS  80    ///< Maximum size of a screen
+
+static uint32_t checks;   ///< Number of checks made
+static uint32_t failures; ///< Number of failed checks
+
+/**
+ * @brief Sizes of the geometries (as in hd44780.c).
+ */
+static const struct {
+  LCD_Geometry_TypeDef geometry;
+  uint8_t columns;
+  uint8_t rows;
+  const char* name;
+} testGeometries[] = {
+  {LCD_16x1, 16, 1, "16x1"},
+  {LCD_16x2, 16, 2, "16x2"},
+  {LCD_20x2, 20, 2, "20x2"},
+  {LCD_20x4, 20, 4, "20x4"},
+  {LCD_40x2, 40, 2, "40x2"},
+};
+
+/**
+ * @brief Runs the driver until it sends everything queued.
+ */
+static void TEST_Flush(void) {
+
+  uint64_t end = SIM_CLOCK_GetTime() + TEST_FLUSH_TIME * 1000000ULL;
+
+  while (SIM_CLOCK_GetTime() < end) {
+    LCD_Update();
+    SIM_CLOCK_Advance(TEST_LOOP_TIME); // rest of the main loop
+  }
+}
+/**
+ * @brief Checks a condition.
+ * @param ok Result of the check
+ * @param test Name of the test
+ * @param what Description of the check
+ */
+static void TEST_Check(uint8_t ok, const char* test, const char* what) {
+
+  checks++;
+  if (!ok) {
+    failures++;
+    printf("FAIL %s: %s\n", test, what);
+  }
+}
+/**
+ * @brief Compares the screen of a display with the expected text.
+ * @param test Name of the test
+ * @param display Display number
+ * @param columns Columns of the display
+ * @param rows Rows of the display
+ * @param expected Expected characters, row after row
+ */
+static void TEST_Screen(const char* test, uint8_t display, uint8_t columns,
+    uint8_t rows, const char* expected) {
+
+  uint8_t screen[TEST_MAX_CHARS];
+
+  TEST_Flush();
+  LCD_SIM_GetScreen(display, columns, rows, screen);
+
+  checks++;
+  if (memcmp(screen, expected, columns * rows)) {
+    failures++;
+    printf("FAIL %s: screen\nexpected:\n", test);
+    uint8_t y;
+    for (y = 0; y < rows; y++) {
+      printf("|%.*s|\n", columns, &expected[y * columns]);
+    }
+    printf("got:\n");
+    LCD_SIM_Print(display, columns, rows);
+  }
+}
+/**
+ * @brief Checks that the controller was never written while busy.
+ * @param test Name of the test
+ */
+static void TEST_Timing(const char* test) {
+
+  LCD_SIM_Stats_TypeDef stats;
+  LCD_SIM_GetStats(&stats);
+
+  checks++;
+  if (stats.violations) {
+    failures++;
+    printf("FAIL %s: %u transfers while busy\n", test, (unsigned)stats.violations);
+  }
+}
+/**
+ * @brief Powers the controllers on and initializes display 0.
+ * @param geometry Geometry of the display
+ */
+static void TEST_Start(LCD_Geometry_TypeDef geometry) {
+
+  LCD_SIM_Reset();
+  LCD_Select(LCD0);
+  LCD_Init(geometry);
+}
+
+/**
+ * @brief Every geometry starts blank and wraps text through all rows.
+ */
+static void TEST_Geometries(void) {
+
+  char expected[TEST_MAX_CHARS + 1];
+  char text[TEST_MAX_CHARS + 1];
+  uint8_t i, j;
+
+  for (i = 0; i < sizeof(testGeometries)/sizeof(testGeometries[0]); i++) {
+
+    uint8_t size = testGeometries[i].columns * testGeometries[i].rows;
+    const char* name = testGeometries[i].name;
+
+    TEST_Start(testGeometries[i].geometry);
+
+    memset(expected, ' ', size);
+    TEST_Screen(name, LCD0, testGeometries[i].columns, testGeometries[i].rows, expected);
+    TEST_Check(LCD_GetColumns() == testGeometries[i].columns, name, "columns");
+    TEST_Check(LCD_GetRows() == testGeometries[i].rows, name, "rows");
+
+    // one character more than fits - the last one wraps to the top
+    for (j = 0; j < size; j++) {
+      text[j] = 'A' + j % 26;
+    }
+    text[size] = '\0';
+    memcpy(expected, text, size);
+    expected[0] = '#';
+
+    LCD_Puts(text);
+    LCD_Putc('#');
+
+    TEST_Screen(name, LCD0, testGeometries[i].columns, testGeometries[i].rows, expected);
+    TEST_Timing(name);
+  }
+}
+/**
+ * @brief Positioning, new lines, fields and clearing.
+ */
+static void TEST_Text(void) {
+
+  TEST_Start(LCD_16x2);
+
+  LCD_Puts("Hello\nworld");
+  TEST_Screen("newline", LCD0, 16, 2,
+      "Hello           "
+      "world           ");
+
+  LCD_Position(10, 0);
+  LCD_Putc('*');
+  LCD_Printf(0, 1, "T=%d.%dC", 21, 5);
+  LCD_PutInt(12, 1, 4, -42);
+  TEST_Screen("fields", LCD0, 16, 2,
+      "Hello     *     "
+      "T=21.5C      -42");
+
+  LCD_Write(0, 0, "Hello", 5); // unchanged - nothing is sent
+  LCD_SIM_Stats_TypeDef before, after;
+  TEST_Flush();
+  LCD_SIM_GetStats(&before);
+  LCD_Write(0, 0, "Hello", 5);
+  TEST_Flush();
+  LCD_SIM_GetStats(&after);
+  TEST_Check(after.data == before.data, "shadow", "unchanged text sent again");
+
+  LCD_Clear();
+  LCD_Puts("Clear");
+  TEST_Screen("clear", LCD0, 16, 2,
+      "Clear           "
+      "                ");
+
+  TEST_Timing("text");
+}
+/**
+ * @brief Custom characters don't move the cursor.
+ */
+static void TEST_CustomChars(void) {
+
+  static const uint8_t bitmap[8] = {0x1f, 0x11, 0x11, 0x11, 0x11, 0x11, 0x1f, 0x00};
+
+  TEST_Start(LCD_16x2);
+
+  LCD_Puts("ab");
+  LCD_DefineChar(3, bitmap);
+  LCD_Putc(3);
+  TEST_Screen("cgram", LCD0, 16, 2,
+      "ab\003             "
+      "                ");
+  TEST_Check(!memcmp(LCD_SIM_GetCGRAM(0) + 3 * 8, bitmap, 8), "cgram", "bitmap");
+
+  // cursor just past the end of the row (regression)
+  TEST_Start(LCD_40x2);
+  LCD_Puts("0123456789012345678901234567890123456789");
+  LCD_DefineChar(0, bitmap);
+  LCD_Puts("AB");
+  TEST_Screen("cgram at end of row", LCD0, 40, 2,
+      "0123456789012345678901234567890123456789"
+      "AB                                      ");
+
+  TEST_Timing("cgram");
+}
+/**
+ * @brief Text dropped from a full queue doesn't end up elsewhere.
+ * @details The queue is filled with commands up to different
+ * levels, so that it overflows at every point of a run.
+ * Each cell gets its own character and shows it or stays blank.
+ * Writing the same text again completes the screen.
+ */
+static void TEST_QueueFull(void) {
+
+  char text[TEST_MAX_CHARS];
+  char expected[TEST_MAX_CHARS];
+  uint8_t screen[TEST_MAX_CHARS];
+  uint8_t fill, i;
+
+  for (i = 0; i < TEST_MAX_CHARS; i++) {
+    text[i] = '0' + i;
+  }
+
+  for (fill = 0; fill < 12; fill++) {
+
+    TEST_Start(LCD_40x2);
+    TEST_Flush();
+
+    for (i = 0; i < 200 + fill; i++) {
+      LCD_Position(0, 0);
+    }
+    // runs of 3 characters with a gap - address set before each
+    for (i = 0; i < TEST_MAX_CHARS; i += 4) {
+      LCD_Write(i % 40, i / 40, &text[i], 3);
+    }
+
+    TEST_Flush();
+    LCD_SIM_GetScreen(LCD0, 40, 2, screen);
+
+    uint8_t misplaced = 0;
+    for (i = 0; i < TEST_MAX_CHARS; i++) {
+      if (screen[i] != ' ' && screen[i] != (uint8_t)text[i]) {
+        misplaced = 1;
+      }
+    }
+    TEST_Check(!misplaced, "queue full", "character in wrong cell");
+
+    // dropped characters aren't in the shadow - writing again sends them
+    for (i = 0; i < TEST_MAX_CHARS; i += 4) {
+      LCD_Write(i % 40, i / 40, &text[i], 3);
+    }
+    for (i = 0; i < TEST_MAX_CHARS; i++) {
+      expected[i] = (i % 4 == 3) ? ' ' : text[i];
+    }
+    TEST_Screen("queue full retry", LCD0, 40, 2, expected);
+    TEST_Timing("queue full");
+  }
+}
+
+#ifdef LCD_ASYNC_INIT
+/**
+ * @brief LCD_Init returns at once and earlier text isn't lost.
+ */
+static void TEST_AsyncInit(void) {
+
+  LCD_SIM_Reset();
+  LCD_Select(LCD0);
+
+  uint64_t start = SIM_CLOCK_GetTime();
+  LCD_Init(LCD_16x2);
+  TEST_Check(SIM_CLOCK_GetTime() - start < 1000000, "async init", "LCD_Init blocked");
+
+  LCD_Puts("Early");
+  TEST_Screen("async init", LCD0, 16, 2,
+      "Early           "
+      "                ");
+  TEST_Timing("async init");
+}
+#endif
+
+#if LCD_DISPLAYS > 1
+/**
+ * @brief Displays on the shared bus are independent.
+ */
+static void TEST_Displays(void) {
+
+  LCD_SIM_Reset();
+
+  LCD_Select(LCD0);
+  LCD_Init(LCD_16x2);
+  LCD_Select(LCD1);
+  LCD_Init(LCD_20x4);
+
+  LCD_Select(LCD0);
+  LCD_Puts("First");
+  LCD_Select(LCD1);
+  LCD_Position(0, 3);
+  LCD_Puts("Second");
+
+  TEST_Screen("display 0", LCD0, 16, 2,
+      "First           "
+      "                ");
+  TEST_Screen("display 1", LCD1, 20, 4,
+      "                    "
+      "                    "
+      "                    "
+      "Second              ");
+  TEST_Timing("displays");
+}
+#endif
+
+int main(void) {
+
+  TIMER_Init(1000);
+
+  TEST_Geometries();
+  TEST_Text();
+  TEST_CustomChars();
+  TEST_QueueFull();
+#ifdef LCD_ASYNC_INIT
+  TEST_AsyncInit();
+#endif
+#if LCD_DISPLAYS > 1
+  TEST_Displays();
+#endif
+
+  printf("%u checks, %u failed\n", (unsigned)checks, (unsigned)failures);
+
+  return failures ? 1 : 0;
+}
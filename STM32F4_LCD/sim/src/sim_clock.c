@@ -0,0 +1,90 @@
+/**
+ * @file:   sim_clock.c
+ * @brief:  Simulated time base for host builds
+ * @date:   18 paź 2026
+ * @author: agent
+ *
+ * Replaces systick.c and timer5.c on the host. Time is kept
+ * in nanoseconds and moves only when something spends it:
+ * the simulated LCD bus, or the CPU reading the clock (every
+ * read costs SIM_CLOCK_POLL_TIME, so busy waiting loops end).
+ *
+ * @verbatim
+ * Copyright (c) 2026 agent.
+ * All rights reserved. This program and the
+ * accompanying materials are made available
+ * under the terms of the GNU Public License
+ * v3.0 which accompanies this distribution,
+ * and is available at
+ * http://www.gnu.org/licenses/gpl.html
+ * @endverbatim
+ */
+
+#include <sim_clock.h>
+#include <systick.h>
+#include <timer5.h>
+
+/**
+ * @addtogroup SIM_CLOCK
+ * @{
+ */
+
+#ifndef SIM_CLOCK_POLL_TIME
+  #define SIM_CLOCK_POLL_TIME 100 ///< CPU time of one clock read in ns
+#endif
+
+static uint64_t simTime; ///< Simulated time in ns
+static uint32_t tickNs;  ///< SysTick period in ns
+
+/**
+ * @brief Sets the time back to zero (power on).
+ */
+void SIM_CLOCK_Reset(void) {
+  simTime = 0;
+}
+/**
+ * @brief Moves the time forward.
+ * @param ns Time in ns
+ */
+void SIM_CLOCK_Advance(uint32_t ns) {
+  simTime += ns;
+}
+/**
+ * @brief Returns the simulated time.
+ * @return Time in ns
+ */
+uint64_t SIM_CLOCK_GetTime(void) {
+  return simTime;
+}
+/**
+ * @brief Simulated SysTick initialization.
+ * @param freq SysTick frequency
+ */
+void SYSTICK_Init(uint32_t freq) {
+  tickNs = 1000000000UL / freq;
+}
+/**
+ * @brief Simulated system time.
+ * @return Number of SysTick periods (ms if not initialized)
+ */
+uint32_t SYSTICK_GetTime(void) {
+  simTime += SIM_CLOCK_POLL_TIME;
+  return simTime / (tickNs ? tickNs : 1000000);
+}
+/**
+ * @brief Simulated microsecond timer initialization.
+ */
+void TIMER5_Init(void) {
+}
+/**
+ * @brief Simulated microsecond timer.
+ * @return Time in us
+ */
+uint32_t TIMER5_GetTime(void) {
+  simTime += SIM_CLOCK_POLL_TIME;
+  return simTime / 1000;
+}
+
+/**
+ * @}
+ */